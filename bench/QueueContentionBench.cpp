@@ -0,0 +1,159 @@
+// Property-read latency on a camera's command queue while content work runs.
+//
+// The SDK is replaced by a fake camera whose calls just take time: a pull is
+// a short PullContentsFile call followed by a long transfer, thumbnails take
+// a few tens of milliseconds each, property reads a few milliseconds. Reads
+// are timed from submit to result in three scenarios:
+//
+//   idle      nothing else on the camera
+//   held      the whole transfer runs on the queue thread (how pulls used
+//             to wait for OnNotifyContentsTransfer)
+//   released  only PullContentsFile runs on the queue; the transfer is
+//             waited for off it, as CameraDeviceWrapper does now
+//
+// Both loaded scenarios also keep thumbnails queued back to back.
+//
+// Build with -DBUILD_BENCHMARKS=ON and run crsdk_queue_bench [options].
+
+#include "camera/CameraCommandQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace crsdk_rest;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    int transferMs = 3000;
+    int pullCallMs = 20;
+    int thumbnailMs = 40;
+    int readMs = 5;
+    int readIntervalMs = 50;
+};
+
+// Stands in for the SDK: every call just takes its time
+void fakeSdkCall(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+enum class Scenario { Idle, Held, Released };
+
+struct Result {
+    std::vector<double> latencies;
+};
+
+Result runScenario(Scenario scenario, const Options& opt) {
+    CameraCommandQueue queue(0);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> load;
+
+    if (scenario != Scenario::Idle) {
+        // One large pull
+        load.emplace_back([&]() {
+            if (scenario == Scenario::Held) {
+                queue.run<bool>(CommandPriority::Content, [&]() {
+                    fakeSdkCall(opt.pullCallMs + opt.transferMs);
+                    return true;
+                }, std::chrono::milliseconds(opt.transferMs * 2));
+            } else {
+                queue.run<bool>(CommandPriority::Content, [&]() {
+                    fakeSdkCall(opt.pullCallMs);
+                    return true;
+                });
+                fakeSdkCall(opt.transferMs);  // Waiting for the completion callback
+            }
+            done = true;
+        });
+
+        // A grid of thumbnails, always a few queued
+        load.emplace_back([&]() {
+            while (!done) {
+                std::vector<std::shared_future<bool>> batch;
+                for (int i = 0; i < 4; i++) {
+                    batch.push_back(queue.submit<bool>(CommandPriority::Content, [&]() {
+                        fakeSdkCall(opt.thumbnailMs);
+                        return true;
+                    }));
+                }
+                for (auto& f : batch) {
+                    f.wait();
+                }
+            }
+        });
+    }
+
+    // Let the load start before measuring
+    std::this_thread::sleep_for(std::chrono::milliseconds(opt.pullCallMs * 2));
+
+    Result result;
+    auto until = Clock::now() + std::chrono::milliseconds(opt.transferMs - opt.pullCallMs * 4);
+    while (Clock::now() < until) {
+        auto start = Clock::now();
+        queue.run<bool>(CommandPriority::PropertyRead, [&]() {
+            fakeSdkCall(opt.readMs);
+            return true;
+        }, std::chrono::milliseconds(opt.transferMs * 2));
+        result.latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(opt.readIntervalMs));
+    }
+
+    done = true;
+    for (auto& t : load) {
+        t.join();
+    }
+    queue.stop();
+    return result;
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t i = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    return values[std::min(i, values.size() - 1)];
+}
+
+void report(const char* name, const Result& result) {
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << result.latencies.size()
+              << std::setw(10) << percentile(result.latencies, 0.5)
+              << std::setw(10) << percentile(result.latencies, 0.95)
+              << std::setw(10) << percentile(result.latencies, 1.0) << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--transfer-ms" && i + 1 < argc) {
+            opt.transferMs = std::atoi(argv[++i]);
+        } else if (arg == "--thumbnail-ms" && i + 1 < argc) {
+            opt.thumbnailMs = std::atoi(argv[++i]);
+        } else if (arg == "--read-ms" && i + 1 < argc) {
+            opt.readMs = std::atoi(argv[++i]);
+        } else if (arg == "--help" || arg == "-h") {
+            std::cout << "Usage: " << argv[0] << " [--transfer-ms 3000] [--thumbnail-ms 40] [--read-ms 5]\n";
+            return 0;
+        }
+    }
+
+    std::cout << "Property read latency (ms), transfer " << opt.transferMs << " ms, thumbnails "
+              << opt.thumbnailMs << " ms, reads " << opt.readMs << " ms\n";
+    std::cout << std::left << std::setw(10) << "scenario" << std::right << std::setw(8) << "reads"
+              << std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "max" << "\n";
+    report("idle", runScenario(Scenario::Idle, opt));
+    report("held", runScenario(Scenario::Held, opt));
+    report("released", runScenario(Scenario::Released, opt));
+    return 0;
+}
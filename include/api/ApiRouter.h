@@ -24,19 +24,40 @@ private:
     static void handleListCameras(const httplib::Request& req, httplib::Response& res);
     static void handleConnectedCameras(const httplib::Request& req, httplib::Response& res);
     static void handleConnectCamera(const httplib::Request& req, httplib::Response& res);
+    static void handleConnectAll(const httplib::Request& req, httplib::Response& res);
     static void handleDisconnectCamera(const httplib::Request& req, httplib::Response& res);
+    static void handleCameraHealth(const httplib::Request& req, httplib::Response& res);
 
     // Property endpoints
     static void handleGetProperties(const httplib::Request& req, httplib::Response& res);
     static void handleSetProperty(const httplib::Request& req, httplib::Response& res);
 
+    // Preset endpoints
+    static void handleListPresets(const httplib::Request& req, httplib::Response& res);
+    static void handleGetPreset(const httplib::Request& req, httplib::Response& res);
+    static void handleDeletePreset(const httplib::Request& req, httplib::Response& res);
+    static void handleSavePreset(const httplib::Request& req, httplib::Response& res);
+    static void handleApplyPreset(const httplib::Request& req, httplib::Response& res);
+
     // Command endpoints
     static void handleSendCommand(const httplib::Request& req, httplib::Response& res);
     static void handleCapture(const httplib::Request& req, httplib::Response& res);
+    static void handleGroupCapture(const httplib::Request& req, httplib::Response& res);
+    static void handleBracket(const httplib::Request& req, httplib::Response& res);
     static void handleRecordStart(const httplib::Request& req, httplib::Response& res);
     static void handleRecordStop(const httplib::Request& req, httplib::Response& res);
     static void handleFocus(const httplib::Request& req, httplib::Response& res);
 
+    // Capture job endpoints
+    static void handleGetCaptureJob(const httplib::Request& req, httplib::Response& res);
+    static void handleWaitCaptureJob(const httplib::Request& req, httplib::Response& res);
+
+    // Sequence endpoints
+    static void handleStartSequence(const httplib::Request& req, httplib::Response& res);
+    static void handleListSequences(const httplib::Request& req, httplib::Response& res);
+    static void handleGetSequence(const httplib::Request& req, httplib::Response& res);
+    static void handleControlSequence(const httplib::Request& req, httplib::Response& res);
+
     // Live view endpoints
     static void handleLiveViewImage(const httplib::Request& req, httplib::Response& res);
     static void handleLiveViewInfo(const httplib::Request& req, httplib::Response& res);
@@ -46,11 +67,32 @@ private:
     static void handleGetContents(const httplib::Request& req, httplib::Response& res);
     static void handleGetContentInfo(const httplib::Request& req, httplib::Response& res);
     static void handleDownloadContent(const httplib::Request& req, httplib::Response& res);
+    static void handleDownloadArchive(const httplib::Request& req, httplib::Response& res);
+    static void handleQueryCatalog(const httplib::Request& req, httplib::Response& res);
     static void handleGetThumbnail(const httplib::Request& req, httplib::Response& res);
+    static void handleBatchThumbnails(const httplib::Request& req, httplib::Response& res);
+    static void handleListTransfers(const httplib::Request& req, httplib::Response& res);
+    // X-Client-Id, or the peer address without one; the unit of fairness
+    // between clients
+    static std::string clientFor(const httplib::Request& req);
+    // 503 when a transfer waited its limit for a slot
+    static void replyQueueFull(httplib::Response& res);
+    // Sets ETag/Accept-Ranges and evaluates If-None-Match and If-Range.
+    // Returns true if it answered 304.
+    static bool applyValidators(const httplib::Request& req, httplib::Response& res, const std::string& etag);
+
+    // Offload endpoints
+    static void handleOffloadStats(const httplib::Request& req, httplib::Response& res);
+    static void handleSetOffload(const httplib::Request& req, httplib::Response& res);
 
     // Health check
     static void handleHealth(const httplib::Request& req, httplib::Response& res);
 
+    // Debug endpoints
+    static void handleSdkStats(const httplib::Request& req, httplib::Response& res);
+    static void handleResetSdkStats(const httplib::Request& req, httplib::Response& res);
+    static void handleContentCacheStats(const httplib::Request& req, httplib::Response& res);
+
     // GRBL/CNC endpoints
     static void handleGrblListPorts(const httplib::Request& req, httplib::Response& res);
     static void handleGrblConnect(const httplib::Request& req, httplib::Response& res);
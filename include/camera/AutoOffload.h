@@ -0,0 +1,123 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <unordered_set>
+#include <cstdint>
+#include "CameraDeviceWrapper.h"
+#include "ContentSpool.h"
+#include "TransferScheduler.h"
+#include "ContentStore.h"
+
+namespace crsdk_rest {
+
+// Copies new captures off each camera as they appear, into a directory per
+// camera. A camera's files are pulled one at a time on its own thread, after
+// the camera has been left alone for a moment (or after a bounded wait),
+// and optionally held under a bandwidth cap. Pulls go through the transfer
+// scheduler as bulk work. Files are kept in a content store under the
+// directory: one already stored with the same size and hash is not pulled
+// again, and identical files share their space.
+class AutoOffload {
+public:
+    using CameraLookup = std::function<std::shared_ptr<CameraDeviceWrapper>(int cameraIndex)>;
+    using EventFn = std::function<void(const CameraEvent&)>;
+
+    AutoOffload(CameraLookup lookup, ContentSpool& spool, TransferScheduler& transfers, EventFn emit);
+    ~AutoOffload();
+
+    // An empty directory leaves offloading off. maxMbps 0 is unlimited.
+    bool open(const std::string& dir, double maxMbps);
+    void stop();  // Drop queued work and join
+
+    bool isEnabled() const;
+    // Per camera, on by default once open
+    void setCameraEnabled(int cameraIndex, bool enabled);
+
+    // From camera events: a content the camera reported, or a file the SDK
+    // already saved on this host after a capture
+    void onNewContent(int cameraIndex, const std::string& cameraIdentity, uint32_t contentHandle);
+    void onCapturedFile(int cameraIndex, const std::string& cameraIdentity, const std::string& path);
+    void onDisconnected(int cameraIndex);  // Queued handles are stale
+
+    nlohmann::json getStats() const;
+
+private:
+    // A camera is quiet after this long without control, property or live
+    // view requests; while it is busy, one file still goes every kMaxDefer
+    static constexpr std::chrono::milliseconds kQuietPeriod{2000};
+    static constexpr std::chrono::milliseconds kMaxDefer{15000};
+    static constexpr const char* kPartialSuffix = ".part";
+
+    struct Item {
+        uint32_t handle = 0;
+        std::string hostPath;  // Set for files the SDK saved itself
+    };
+
+    struct Outcome {
+        std::string dest;
+        std::string hash;
+        uint64_t bytes = 0;      // Size of the file offloaded
+        bool skipped = false;    // Already stored; nothing was pulled
+        bool duplicate = false;  // Pulled, but the store had the bytes
+        std::string error;
+    };
+
+    struct Lane {
+        int cameraIndex = -1;
+        std::string identity;
+        std::string dir;
+        bool enabled = true;
+        std::deque<Item> queue;
+        std::unordered_set<uint32_t> seen;  // Queued or done this session
+
+        std::string state = "idle";  // idle, throttled, transferring
+        uint32_t current = 0;
+        uint64_t completed = 0;
+        uint64_t skipped = 0;
+        uint64_t deduplicated = 0;
+        uint64_t failed = 0;
+        uint64_t bytes = 0;
+        double transferMs = 0;
+        double throttledMs = 0;
+        std::string lastFile;
+        std::string lastError;
+
+        std::thread thread;
+    };
+
+    // Caller holds m_mutex; null when offloading is off or disabled for it
+    std::shared_ptr<Lane> laneFor(int cameraIndex, const std::string& cameraIdentity);
+    void runLane(std::shared_ptr<Lane> lane);
+    // Wait for a quiet camera. Returns false when stopping.
+    bool waitForQuiet(std::unique_lock<std::mutex>& lock, Lane& lane);
+    // Runs without m_mutex
+    void transfer(int cameraIndex, const std::string& identity, const std::string& dir, const Item& item,
+                  Outcome& outcome);
+    static std::string sanitize(const std::string& name);
+
+    static constexpr const char* kClientName = "offload";
+
+    CameraLookup m_lookup;
+    ContentSpool& m_spool;
+    TransferScheduler& m_transfers;
+    EventFn m_emit;
+    ContentStore m_store;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::string m_dir;
+    double m_maxBytesPerSec{0};
+    std::map<int, std::shared_ptr<Lane>> m_lanes;
+    std::unordered_set<int> m_disabled;
+    bool m_stopping{false};
+};
+
+} // namespace crsdk_rest
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <json.hpp>
+
+namespace crsdk_rest {
+
+class CameraDeviceWrapper;
+class CaptureJobTable;
+
+struct BracketOptions {
+    int confirmTimeoutMs = 2000;  // Per step, for the camera to report the new values
+    bool requireConfirm = true;   // Stop instead of shooting with unconfirmed values
+    bool restore = true;          // Put the original values back afterwards
+};
+
+// Shoots one frame per property vector. Each step sets only the codes that
+// differ from the camera's current values, waits for OnPropertyChangedCodes
+// to confirm them, captures and moves straight on to the next step.
+class BracketCapture {
+public:
+    using Step = std::map<uint32_t, uint64_t>;  // Property code -> value
+
+    static nlohmann::json run(const std::shared_ptr<CameraDeviceWrapper>& camera,
+                              const std::vector<Step>& steps,
+                              const BracketOptions& options,
+                              CaptureJobTable& jobs);
+};
+
+} // namespace crsdk_rest
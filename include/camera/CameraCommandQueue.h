@@ -0,0 +1,195 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace crsdk_rest {
+
+// Priority classes for camera work. Lower values run first.
+enum class CommandPriority {
+    Control = 0,       // Shutter, recording, connection
+    PropertySet = 1,
+    PropertyRead = 2,
+    Content = 3,       // Folder listing, thumbnails, transfers
+    Background = 4,    // Prefetching; runs only when nothing else is queued
+};
+
+// Thrown to callers whose camera work missed its deadline
+class SdkTimeoutError : public std::runtime_error {
+public:
+    SdkTimeoutError(int cameraIndex, const std::string& what)
+        : std::runtime_error(what), m_cameraIndex(cameraIndex) {}
+    int getCameraIndex() const { return m_cameraIndex; }
+
+private:
+    int m_cameraIndex;
+};
+
+// Per-camera executor: one worker thread runs submitted work in priority
+// order (FIFO within a priority). Every task has a deadline; a worker that
+// overruns it can be abandoned (see abandonStalledWorker) so the rest of the
+// queue is served by a fresh thread.
+class CameraCommandQueue {
+public:
+    explicit CameraCommandQueue(int cameraIndex);
+    ~CameraCommandQueue();
+
+    CameraCommandQueue(const CameraCommandQueue&) = delete;
+    CameraCommandQueue& operator=(const CameraCommandQueue&) = delete;
+
+    // Default deadline per priority; a zero timeout argument selects it
+    static std::chrono::milliseconds defaultTimeout(CommandPriority priority);
+
+    template <typename T>
+    std::shared_future<T> submit(CommandPriority priority, std::function<T()> fn,
+                                 std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        return enqueue<T>(priority, std::move(fn), timeout).future;
+    }
+
+    // Submit and wait up to the timeout for the result, else throw
+    // SdkTimeoutError (work that has not started by then is dropped).
+    // Called from the worker thread itself the work runs inline, since
+    // waiting on the queue would deadlock.
+    template <typename T>
+    T run(CommandPriority priority, std::function<T()> fn,
+          std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        if (isWorkerThread()) {
+            return fn();
+        }
+        if (timeout.count() <= 0) {
+            timeout = defaultTimeout(priority);
+        }
+        auto call = enqueue<T>(priority, std::move(fn), timeout);
+        if (call.future.wait_for(timeout) != std::future_status::ready) {
+            call.fail(std::make_exception_ptr(SdkTimeoutError(
+                m_state->cameraIndex, "Camera " + std::to_string(m_state->cameraIndex) + " did not respond in time")));
+        }
+        return call.future.get();
+    }
+
+    // If the running task is past its deadline, fail it, leave its thread
+    // behind in the SDK and start a new worker. Returns true if it did.
+    bool abandonStalledWorker();
+
+    // Drain queued work and join the worker thread
+    void stop();
+
+    size_t pending() const;
+    uint64_t abandonedWorkers() const;
+    // When Control, PropertySet or PropertyRead work was last submitted
+    std::chrono::steady_clock::time_point lastInteractive() const;
+    bool isWorkerThread() const { return t_workerState == m_state.get(); }
+    // On a worker thread this queue has since given up on (its call came
+    // back after the deadline); such a thread must not touch shared state
+    bool workerAbandoned() const;
+
+private:
+    struct Task {
+        CommandPriority priority;
+        uint64_t seq;
+        std::chrono::milliseconds timeout;
+        std::function<void()> run;
+        std::function<void(std::exception_ptr)> fail;
+        std::shared_ptr<std::atomic<bool>> settled;  // Result or failure delivered
+    };
+
+    struct TaskOrder {
+        bool operator()(const Task& a, const Task& b) const {
+            if (a.priority != b.priority) {
+                return a.priority > b.priority;
+            }
+            return a.seq > b.seq;
+        }
+    };
+
+    // Shared with the workers so an abandoned one can still return safely
+    struct State {
+        int cameraIndex = -1;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::priority_queue<Task, std::vector<Task>, TaskOrder> queue;
+        uint64_t nextSeq{0};
+        bool stopping{false};
+        uint64_t generation{0};  // Bumped when a stuck worker is abandoned
+        uint64_t abandoned{0};
+        bool running{false};
+        std::chrono::steady_clock::time_point deadline;
+        std::function<void(std::exception_ptr)> failRunning;
+        std::chrono::steady_clock::time_point lastInteractive;
+    };
+
+    template <typename T>
+    struct Call {
+        std::shared_future<T> future;
+        std::function<void(std::exception_ptr)> fail;
+    };
+
+    template <typename T>
+    Call<T> enqueue(CommandPriority priority, std::function<T()> fn, std::chrono::milliseconds timeout);
+
+    static void workerLoop(std::shared_ptr<State> state, uint64_t generation);
+
+    static inline thread_local const State* t_workerState = nullptr;
+    static inline thread_local uint64_t t_workerGeneration = 0;
+
+    std::shared_ptr<State> m_state;
+    std::thread m_worker;  // Guarded by m_state->mutex
+};
+
+template <typename T>
+CameraCommandQueue::Call<T> CameraCommandQueue::enqueue(CommandPriority priority, std::function<T()> fn,
+                                                        std::chrono::milliseconds timeout) {
+    auto promise = std::make_shared<std::promise<T>>();
+    auto settled = std::make_shared<std::atomic<bool>>(false);
+    Call<T> call;
+    call.future = promise->get_future().share();
+    call.fail = [promise, settled](std::exception_ptr error) {
+        if (!settled->exchange(true)) {
+            promise->set_exception(error);
+        }
+    };
+
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+
+    if (m_state->stopping) {
+        call.fail(std::make_exception_ptr(
+            std::runtime_error("Camera " + std::to_string(m_state->cameraIndex) + " command queue stopped")));
+        return call;
+    }
+
+    auto run = [promise, settled, fn = std::move(fn)]() {
+        try {
+            T result = fn();
+            if (!settled->exchange(true)) {
+                promise->set_value(std::move(result));
+            }
+        } catch (...) {
+            if (!settled->exchange(true)) {
+                promise->set_exception(std::current_exception());
+            }
+        }
+    };
+
+    if (timeout.count() <= 0) {
+        timeout = defaultTimeout(priority);
+    }
+    if (priority < CommandPriority::Content) {
+        m_state->lastInteractive = std::chrono::steady_clock::now();
+    }
+    m_state->queue.push(Task{priority, m_state->nextSeq++, timeout, run, call.fail, settled});
+    m_state->cv.notify_one();
+    return call;
+}
+
+} // namespace crsdk_rest
@@ -2,11 +2,23 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <optional>
 #include <memory>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <functional>
 #include <chrono>
+#include <deque>
+#include "CameraCommandQueue.h"
+#include "util/SingleFlight.h"
+#include "ThumbnailCache.h"
+#include "ContentCatalog.h"
+#include "GroupCapture.h"
 #include "CameraRemote_SDK.h"
 #include "IDeviceCallback.h"
 #include <json.hpp>
@@ -24,27 +36,78 @@ struct CameraEvent {
         : type(t), cameraIndex(idx), timestamp(std::chrono::system_clock::now()) {}
 };
 
-class CameraDeviceWrapper : public SCRSDK::IDeviceCallback {
+class CameraDeviceWrapper : public SCRSDK::IDeviceCallback,
+                            public std::enable_shared_from_this<CameraDeviceWrapper> {
 public:
+    static constexpr int kDefaultConnectTimeoutMs = 3000;
+    // Queue deadlines on top of the SDK's own connect timeout; a restore
+    // also reapplies properties
+    static constexpr int kConnectDeadlineSlackMs = 5000;
+    static constexpr int kRestoreDeadlineSlackMs = 15000;
+    static constexpr int kPullWaitMs = 10 * 60 * 1000;  // For the completion callback
+    // A live view frame taking longer than this counts as a hung call
+    static constexpr int kLiveViewDeadlineMs = 5000;
+
+    // infoOwner keeps the enumeration that owns info alive for the session
     CameraDeviceWrapper(int index, SCRSDK::ICrCameraObjectInfo* info,
+                        std::shared_ptr<void> infoOwner,
                         std::function<void(const CameraEvent&)> eventCallback);
     ~CameraDeviceWrapper();
 
     // Connection
-    bool connect(int mode, bool reconnect);
+    // Blocks until OnConnected/OnDisconnected fires or timeoutMs expires
+    bool connect(int mode, bool reconnect, int timeoutMs = kDefaultConnectTimeoutMs);
     bool disconnect();
+    // Release a dropped session and reconnect with the original mode, then
+    // reapply every property set through setProperty. info may be null to
+    // reuse the current object info.
+    bool restoreSession(SCRSDK::ICrCameraObjectInfo* info, std::shared_ptr<void> infoOwner,
+                        int timeoutMs = kDefaultConnectTimeoutMs);
+    // If the SDK call running on the queue is past its deadline, give up on
+    // it and emit sdk_timeout; a live view frame stuck in the SDK is
+    // reported the same way. Returns true if either happened.
+    bool abandonStalledCall();
     bool isConnected() const { return m_connected.load(); }
     int getIndex() const { return m_index; }
+    // How long a finished read (properties, live view info, folders, contents
+    // lists, thumbnails) is reused; 0 shares only reads still in flight
+    void setReadCacheTtl(int ms) { m_readCacheTtlMs.store(ms); }
+    // Thumbnails kept in memory for the session. Listing a folder also
+    // prefetches its thumbnails in the background. 0 disables both.
+    void setThumbnailCacheBudget(size_t bytes) { m_thumbnails.setBudget(bytes); }
     std::string getModel() const { return m_model; }
+    // Time since the last control, property or live view request; background
+    // transfers defer to a camera someone is working with
+    std::chrono::milliseconds getIdleTime() const;
 
     // Properties
     nlohmann::json getAllProperties();
     nlohmann::json getSelectProperties(const std::vector<uint32_t>& codes);
     bool setProperty(uint32_t code, uint64_t value);
+    nlohmann::json getAppliedProperties() const;  // Last value set per code
+    // Change confirmations from OnPropertyChanged(Codes). Take the sequence
+    // number before setting a property, then wait for it to move.
+    uint64_t getPropertyChangeSeq(uint32_t code) const;
+    bool waitForPropertyChange(uint32_t code, uint64_t sinceSeq,
+                               std::chrono::steady_clock::time_point deadline);
 
     // Commands
     bool sendCommand(uint32_t commandId, uint32_t param);
     bool capture();
+    // Queue a capture without waiting; callbacks run on the camera's queue
+    // thread after shutter down and up. The future resolves after release.
+    std::shared_future<bool> captureAsync(
+        std::function<void(bool)> onPressed = nullptr,
+        std::function<void(bool)> onReleased = nullptr);
+    // Arm on the queue thread (optionally S1 half-press), signal the gate,
+    // spin until it opens, then fire. Used by GroupCapture. The deadline
+    // covers armTimeoutMs and holdMs on top of the usual Control one.
+    std::shared_future<bool> synchronizedCapture(
+        std::shared_ptr<SpinGate> gate,
+        std::shared_ptr<ShotTiming> timing,
+        bool halfPress,
+        int holdMs,
+        int armTimeoutMs);
     bool startRecording();
     bool stopRecording();
     bool halfPressShutter();
@@ -58,8 +121,41 @@ public:
     nlohmann::json getDateFolderList();
     nlohmann::json getContentsHandleList(uint32_t folderHandle);
     nlohmann::json getContentsDetailInfo(uint32_t contentHandle);
-    bool pullContentsFile(uint32_t contentHandle, const std::string& savePath);
+    // Pull the original file into saveDir and wait for the transfer to
+    // finish. Returns the saved file's path, empty on failure. The camera's
+    // queue is free while the file transfers, so callers limit how many
+    // pulls run at once (see TransferScheduler).
+    std::string pullContentsFile(uint32_t contentHandle, const std::string& saveDir);
     std::vector<uint8_t> getThumbnail(uint32_t contentHandle);
+    // Queue a thumbnail read without waiting for it. Once cancelled is set,
+    // reads still queued resolve empty without calling the SDK. hold (a
+    // transfer ticket, say) is released as soon as the read is over.
+    std::shared_future<std::vector<uint8_t>> fetchThumbnailAsync(uint32_t contentHandle,
+                                                                 std::shared_ptr<std::atomic<bool>> cancelled,
+                                                                 std::shared_ptr<void> hold = nullptr);
+    // From memory only; never touches the camera
+    std::optional<std::vector<uint8_t>> getCachedThumbnail(uint32_t contentHandle) {
+        return m_thumbnails.get(contentHandle);
+    }
+    // Card catalog. The first query starts building it in the background;
+    // pages cover what is indexed so far. False on a bad cursor.
+    bool queryCatalog(const CatalogQuery& query, CatalogPage& page);
+    nlohmann::json getCatalogStatus();
+    // Modification time (ISO 8601) and size of a content: from the catalog
+    // when it has the entry, else one detail read. False if the camera
+    // does not report them.
+    bool getContentVersion(uint32_t contentHandle, std::string& modified, uint64_t& size);
+    // Same, from the catalog only; never touches the camera
+    bool getCatalogedVersion(uint32_t contentHandle, std::string& modified, uint64_t& size) const;
+    // Hash of a pulled file, shown in the catalog for this session
+    void noteContentHash(uint32_t contentHandle, const std::string& hash) {
+        m_catalog.setHash(contentHandle, hash);
+    }
+    // Empty until the content has been pulled this session
+    std::string getContentHash(uint32_t contentHandle) const {
+        CatalogEntry entry;
+        return m_catalog.get(contentHandle, entry) ? entry.hash : "";
+    }
 
     // IDeviceCallback implementations
     void OnConnected(SCRSDK::DeviceConnectionVersioin version) override;
@@ -75,19 +171,173 @@ public:
     void OnError(CrInt32u error) override;
 
 private:
+    // SDK calls; run only on the command queue thread
+    bool sdkConnect(int mode, bool reconnect, int timeoutMs);
+    bool sdkDisconnect();
+    void publishHandle(SCRSDK::CrDeviceHandle handle);
+    SCRSDK::CrDeviceHandle takeHandle();  // Leaves m_handle 0
+    // Now, or once the last call still using the handle has returned
+    void releaseDevice(SCRSDK::CrDeviceHandle handle);
+
+    // The device handle one SDK call works with: copied once when the call
+    // starts and used for every SDK function in it, including the paired
+    // Release. A handle with leases out is not released. stale() is true
+    // once the session was swapped or the calling worker abandoned, and a
+    // call that sees it must leave the wrapper's state alone.
+    class SessionLease {
+    public:
+        explicit SessionLease(CameraDeviceWrapper& owner);
+        ~SessionLease();
+        SessionLease(const SessionLease&) = delete;
+        SessionLease& operator=(const SessionLease&) = delete;
+
+        SCRSDK::CrDeviceHandle handle() const { return m_handle; }
+        bool stale() const;
+
+    private:
+        CameraDeviceWrapper& m_owner;
+        SCRSDK::CrDeviceHandle m_handle;
+        uint64_t m_generation;
+    };
+    nlohmann::json sdkGetAllProperties(bool* ok = nullptr);
+    nlohmann::json sdkGetSelectProperties(const std::vector<uint32_t>& codes, bool* ok = nullptr);
+    bool sdkSetProperty(uint32_t code, uint64_t value);
+    bool sdkSendCommand(uint32_t commandId, uint32_t param);
+    bool sdkSetS1Lock(bool locked);
+    nlohmann::json sdkGetLiveViewInfo(bool* ok = nullptr);
+    nlohmann::json sdkGetDateFolderList(bool* ok = nullptr);
+    nlohmann::json sdkGetContentsHandleList(uint32_t folderHandle, bool* ok = nullptr);
+    nlohmann::json sdkGetContentsDetailInfo(uint32_t contentHandle, bool* ok = nullptr);
+    uint64_t sdkStartPull(uint32_t contentHandle, const std::string& saveDir);  // Pull id, 0 on failure
+    // Off the queue: wait for OnNotifyContentsTransfer to end a started pull
+    std::string awaitPull(uint64_t pullId, uint32_t contentHandle, const std::string& saveDir);
+    std::vector<uint8_t> sdkGetThumbnail(uint32_t contentHandle);
+
+    // Run a read on the queue, sharing the call with concurrent identical
+    // reads. fn sets ok when the SDK call succeeded; a failed result goes to
+    // the callers already waiting on it but is never served from the cache.
+    template <typename T>
+    T coalescedRead(SingleFlight<T>& flights, const std::string& key, CommandPriority priority,
+                    std::function<T(bool& ok)> fn) {
+        // On the queue thread, joining a call queued behind us would deadlock
+        if (m_queue.isWorkerThread()) {
+            bool ok = false;
+            return fn(ok);
+        }
+        auto ttl = std::chrono::milliseconds(m_readCacheTtlMs.load());
+        return flights.runCacheable(key, ttl, [this, priority, fn](bool& cacheable) {
+            auto read = m_queue.run<std::pair<T, bool>>(priority, [self = shared_from_this(), fn]() {
+                bool ok = false;
+                T value = fn(ok);
+                return std::make_pair(std::move(value), ok);
+            });
+            cacheable = read.second;
+            return std::move(read.first);
+        });
+    }
+
+    // Thumbnail prefetch: one Background task at a time walks the listed
+    // folder from the cursor, so a thumbnail request can move the cursor to
+    // where the client is looking
+    void startPrefetch(uint32_t folderHandle, const nlohmann::json& handles);
+    void notePrefetchHint(uint32_t contentHandle);
+    void schedulePrefetch();  // Caller holds m_prefetchMutex
+    void runPrefetch();       // Queue thread
+    void resetPrefetch();
+
+    // Catalog build: a Background scan lists every folder, then up to
+    // kCatalogInFlight detail reads are queued at a time, each queueing the
+    // next as it finishes. Tasks from an earlier session see a changed
+    // generation and drop their results.
+    static constexpr size_t kCatalogInFlight = 4;
+    void scheduleCatalogScan();      // Caller holds m_catalogMutex
+    void runCatalogScan(uint64_t generation);           // Queue thread
+    void scheduleCatalogDetails();   // Caller holds m_catalogMutex
+    void runCatalogDetail(uint32_t contentHandle, uint64_t generation);  // Queue thread
+    void noteCatalogChange(uint32_t contentHandle);
+    void resetCatalog();
+
     void emitEvent(const std::string& type, const nlohmann::json& data = {});
 
     int m_index;
     SCRSDK::ICrCameraObjectInfo* m_info;
-    SCRSDK::CrDeviceHandle m_handle{0};
+    std::shared_ptr<void> m_infoOwner;
+    std::atomic<SCRSDK::CrDeviceHandle> m_handle{0};
+    std::atomic<uint64_t> m_sessionGeneration{0};  // Bumped whenever m_handle changes
     std::atomic<bool> m_connected{false};
     int m_mode{0};
+    bool m_reconnect{true};
     std::string m_model;
     std::function<void(const CameraEvent&)> m_eventCallback;
 
-    mutable std::mutex m_mutex;
+    // Guards swaps of m_handle against new leases, and the lease counts.
+    // Never held across an SDK call.
+    std::mutex m_handleMutex;
+    std::map<SCRSDK::CrDeviceHandle, int> m_handleLeases;
+    std::set<SCRSDK::CrDeviceHandle> m_releasePending;  // Disconnected, leases still out
+
+    // One live view frame at a time; others skip rather than wait behind it.
+    // m_liveViewStarted (steady_clock ticks, 0 when idle) lets the watchdog
+    // see a frame stuck in the SDK.
     mutable std::mutex m_liveViewMutex;
+    std::atomic<std::chrono::steady_clock::rep> m_liveViewStarted{0};
+    std::atomic<bool> m_liveViewStallReported{false};
+
+    // Signalled by OnConnected/OnDisconnected; m_connectionEvents counts them
+    std::mutex m_connectMutex;
+    std::condition_variable m_connectCv;
+    uint64_t m_connectionEvents{0};
     std::vector<uint8_t> m_liveViewBuffer;
+    std::atomic<std::chrono::steady_clock::rep> m_lastLiveView{0};  // steady_clock ticks
+
+    // Pulls waiting for OnNotifyContentsTransfer, by pull id (in start order)
+    struct PullResult {
+        uint32_t contentHandle = 0;
+        bool done = false;
+        bool ok = false;
+        std::string filename;
+    };
+    std::mutex m_pullMutex;
+    std::condition_variable m_pullCv;
+    std::map<uint64_t, PullResult> m_pulls;
+    uint64_t m_nextPullId{1};
+
+    // Values written through setProperty, reapplied after a reconnect
+    mutable std::mutex m_appliedMutex;
+    std::map<uint32_t, uint64_t> m_appliedProperties;
+
+    // Per-code change counters; OnPropertyChanged without codes bumps
+    // m_propertyChangeAll, which counts as a change of every code
+    mutable std::mutex m_propertyChangeMutex;
+    std::condition_variable m_propertyChangeCv;
+    std::unordered_map<uint32_t, uint64_t> m_propertyChangeSeq;
+    uint64_t m_propertyChangeAll{0};
+
+    // Keys: "properties", "properties:<codes>", "liveview_info", "folders",
+    // "contents:<folder>", "detail:<handle>"; thumbnails by handle
+    SingleFlight<nlohmann::json> m_reads;
+    SingleFlight<std::vector<uint8_t>> m_thumbnailReads;
+    std::atomic<int> m_readCacheTtlMs{0};
+
+    ThumbnailCache m_thumbnails;
+    std::mutex m_prefetchMutex;
+    uint32_t m_prefetchFolder{0};
+    std::vector<uint32_t> m_prefetchOrder;                  // Listing order
+    std::unordered_map<uint32_t, size_t> m_prefetchIndex;   // Handle -> position
+    std::unordered_set<uint32_t> m_prefetchPending;
+    size_t m_prefetchCursor{0};
+    bool m_prefetchScheduled{false};
+
+    ContentCatalog m_catalog;
+    std::mutex m_catalogMutex;
+    bool m_catalogStarted{false};
+    bool m_catalogScanQueued{false};
+    bool m_catalogScanAgain{false};      // Changed while a scan was listing
+    std::deque<uint32_t> m_catalogPending;  // Listed, details not yet queued
+    size_t m_catalogInFlight{0};
+    uint64_t m_catalogGeneration{0};
+
+    CameraCommandQueue m_queue;
 };
 
 } // namespace crsdk_rest
@@ -7,18 +7,36 @@
 #include <atomic>
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
+#include <thread>
 #include "CameraDeviceWrapper.h"
+#include "CaptureJobTable.h"
+#include "ConnectionSupervisor.h"
+#include "CaptureSequencer.h"
+#include "PropertyPresetStore.h"
+#include "ContentSpool.h"
+#include "ContentCache.h"
+#include "AutoOffload.h"
+#include "TransferScheduler.h"
 
 namespace crsdk_rest {
 
 struct CameraInfo {
     int index;
     std::string id;
+    std::string identity;  // Stable device key (model + device id)
     std::string model;
     std::string connectionType;
     bool sshSupported;
 };
 
+struct ConnectResult {
+    int index = -1;
+    bool connected = false;
+    std::string model;
+    double elapsedMs = 0;
+};
+
 class CameraManager {
 public:
     static CameraManager& getInstance();
@@ -28,24 +46,64 @@ public:
     void shutdown();
     bool isInitialized() const { return m_initialized.load(); }
 
-    // Discovery
-    std::vector<CameraInfo> enumerateCameras(uint8_t timeoutSec = 3);
+    // Discovery. Indices are assigned once per device identity and stay
+    // stable across rescans; absent cameras are left out of the list.
+    std::vector<CameraInfo> enumerateCameras(uint8_t timeoutSec = 3);  // Rescan now
+    std::vector<CameraInfo> getCameraList();                           // Cached result
+    std::string getCameraIdentity(int cameraIndex);                    // Empty if unknown
+    bool hasScanned() const { return m_scanned.load(); }
+    void startDiscovery(int intervalSec);
+    void stopDiscovery();
 
     // Connection management
     std::shared_ptr<CameraDeviceWrapper> connectCamera(
         int cameraIndex,
         int mode = 0,  // 0=Remote, 1=ContentsTransfer
-        bool reconnect = true
+        bool reconnect = true,
+        int timeoutMs = CameraDeviceWrapper::kDefaultConnectTimeoutMs
+    );
+    // Connect every enumerated camera concurrently
+    std::vector<ConnectResult> connectAll(
+        int mode = 0,
+        bool reconnect = true,
+        int timeoutMs = CameraDeviceWrapper::kDefaultConnectTimeoutMs
     );
     void disconnectCamera(int cameraIndex);
     void disconnectAll();
     std::shared_ptr<CameraDeviceWrapper> getConnectedCamera(int cameraIndex);
     std::vector<int> getConnectedCameraIndices();
 
+    // Reuse finished camera reads for this long (0 = only join in-flight reads)
+    void setReadCacheTtl(int ms) { m_readCacheTtlMs.store(ms); }
+    // In-memory thumbnail budget per connected camera (0 = no cache, no prefetch)
+    void setThumbnailCacheBudget(size_t bytes) { m_thumbnailCacheBytes.store(bytes); }
+
+    // Session supervision (state machine and timings per connected camera)
+    nlohmann::json getSessionHealth(int cameraIndex) const;
+    std::string getSessionState(int cameraIndex) const;
+
     // SDK info
     uint32_t getSDKVersion();
     uint32_t getSDKSerial();
 
+    // Capture jobs (completed through capture_complete events)
+    CaptureJobTable& getCaptureJobs() { return m_captureJobs; }
+
+    // Server-side timelapse/burst sequences
+    CaptureSequencer& getSequencer() { return m_sequencer; }
+
+    // Named property presets
+    PropertyPresetStore& getPresets() { return m_presets; }
+
+    // Scratch space for original files pulled for download
+    ContentSpool& getSpool() { return m_spool; }
+    // Originals and thumbnails kept on disk across requests and restarts
+    ContentCache& getContentCache() { return m_contentCache; }
+    // Background copies of new captures (fed by camera events)
+    AutoOffload& getOffload() { return m_offload; }
+    // Admission of thumbnail reads and file pulls, per camera
+    TransferScheduler& getTransfers() { return m_transfers; }
+
     // Event callback
     void setEventHandler(std::function<void(const CameraEvent&)> handler);
     void dispatchEvent(const CameraEvent& event);
@@ -56,11 +114,60 @@ private:
     CameraManager(const CameraManager&) = delete;
     CameraManager& operator=(const CameraManager&) = delete;
 
+    using CameraMap = std::unordered_map<int, std::shared_ptr<CameraDeviceWrapper>>;
+
+    struct DiscoveredCamera {
+        CameraInfo info;
+        SCRSDK::ICrCameraObjectInfo* objectInfo = nullptr;
+        std::shared_ptr<SCRSDK::ICrEnumCameraObjectInfo> owner;  // Keeps objectInfo alive
+        bool present = false;
+    };
+
+    static constexpr uint8_t kDiscoveryScanTimeoutSec = 3;
+
+    // Rebuild the read-only registry copy after m_cameras changes
+    void publishSnapshot();
+    // Disconnect cameras already removed from m_cameras; caller must not hold m_mutex
+    void disconnectDetached(const CameraMap& cameras);
+    bool recoverCamera(int cameraIndex);  // Supervisor reconnect hook
+    std::vector<int> abandonStalledCalls();  // Supervisor stall check hook
+    void scanCameras(uint8_t timeoutSec);
+    void discoveryLoop(int intervalSec);
+
     std::atomic<bool> m_initialized{false};
+    std::atomic<int> m_readCacheTtlMs{0};
+    std::atomic<size_t> m_thumbnailCacheBytes{0};
     mutable std::mutex m_mutex;
-    std::unordered_map<int, std::shared_ptr<CameraDeviceWrapper>> m_cameras;
-    std::vector<void*> m_cameraInfoList;  // Store ICrCameraObjectInfo pointers
+    CameraMap m_cameras;                          // Guarded by m_mutex
+    std::shared_ptr<const CameraMap> m_snapshot;  // Immutable copy, std::atomic_load/store only
+    std::unordered_set<int> m_connecting;  // Indices with a connect in flight
+    std::vector<DiscoveredCamera> m_discovered;  // Position == camera index
+    std::mutex m_scanMutex;                      // Serializes EnumCameraObjects
+    std::atomic<bool> m_scanned{false};
+    std::atomic<bool> m_discoveryRunning{false};
+    std::thread m_discoveryThread;
     std::function<void(const CameraEvent&)> m_eventHandler;
+    CaptureJobTable m_captureJobs;
+    PropertyPresetStore m_presets;
+    ContentSpool m_spool;
+    ContentCache m_contentCache;
+    TransferScheduler m_transfers;
+    AutoOffload m_offload{
+        [this](int cameraIndex) { return getConnectedCamera(cameraIndex); },
+        m_spool,
+        m_transfers,
+        [this](const CameraEvent& event) { dispatchEvent(event); }
+    };
+    ConnectionSupervisor m_supervisor{
+        [this](int cameraIndex) { return recoverCamera(cameraIndex); },
+        [this](const CameraEvent& event) { dispatchEvent(event); },
+        [this]() { return abandonStalledCalls(); }
+    };
+    CaptureSequencer m_sequencer{
+        [this](int cameraIndex) { return getConnectedCamera(cameraIndex); },
+        m_captureJobs,
+        [this](const CameraEvent& event) { dispatchEvent(event); }
+    };
 };
 
 } // namespace crsdk_rest
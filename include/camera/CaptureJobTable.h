@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <optional>
+#include <vector>
+#include <cstdint>
+#include <json.hpp>
+
+namespace crsdk_rest {
+
+enum class CaptureJobState {
+    Pending,     // Queued on the camera
+    Pressed,     // Shutter down sent
+    Released,    // Shutter up sent, waiting for the image
+    Downloaded,  // OnCompleteDownload delivered the file
+    Failed
+};
+
+struct CaptureJob {
+    uint64_t id = 0;
+    int cameraIndex = -1;
+    CaptureJobState state = CaptureJobState::Pending;
+    std::string filename;            // First file delivered
+    std::vector<std::string> files;  // Every file of the shot (RAW+JPEG gives two)
+    std::string error;
+    std::chrono::system_clock::time_point createdAt;
+    std::chrono::steady_clock::time_point created;
+    std::chrono::steady_clock::time_point pressed;
+    std::chrono::steady_clock::time_point released;
+    std::chrono::steady_clock::time_point downloaded;
+
+    bool isFinished() const {
+        return state == CaptureJobState::Downloaded || state == CaptureJobState::Failed;
+    }
+};
+
+// Tracks captures from shutter press until the camera delivers the file.
+// A download that shares its base name with a file a job already has is
+// another file of that shot; any other download goes to the oldest
+// outstanding job of the same camera.
+class CaptureJobTable {
+public:
+    uint64_t create(int cameraIndex);
+    void markPressed(uint64_t id);
+    void markReleased(uint64_t id);
+    void markFailed(uint64_t id, const std::string& error);
+    void onDownloadComplete(int cameraIndex, const std::string& filename);
+
+    std::optional<CaptureJob> get(uint64_t id) const;
+
+    // Block until the job is downloaded/failed or the timeout expires
+    std::optional<CaptureJob> waitFor(uint64_t id, std::chrono::milliseconds timeout);
+
+    static nlohmann::json toJson(const CaptureJob& job);
+    static std::string stateName(CaptureJobState state);
+
+private:
+    void prune();
+    static std::string stemOf(const std::string& filename);
+
+    // Jobs kept after they finish, and how long an undelivered job may still
+    // claim a download (cameras not saving to host never deliver one)
+    static constexpr size_t kMaxJobs = 4096;
+    static constexpr std::chrono::seconds kDownloadMatchWindow{60};
+    // How long after its first file a job still collects the rest of the shot
+    static constexpr std::chrono::seconds kSiblingWindow{10};
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::map<uint64_t, CaptureJob> m_jobs;
+    uint64_t m_nextId{1};
+};
+
+} // namespace crsdk_rest
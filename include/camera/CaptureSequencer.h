@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include "CameraDeviceWrapper.h"
+#include "CaptureJobTable.h"
+
+namespace crsdk_rest {
+
+enum class SequenceState {
+    Scheduled,  // Waiting for the start time
+    Running,
+    Paused,
+    Completed,
+    Cancelled,
+    Failed
+};
+
+struct SequenceOptions {
+    int count = 1;
+    int intervalMs = 0;   // 0 = burst, fire each frame as soon as the previous one is released
+    int64_t startAt = 0;  // Unix time in ms; 0 = now
+};
+
+struct SequenceFrame {
+    int frame = 0;
+    uint64_t jobId = 0;
+    bool captured = false;
+    double latenessMs = 0;  // Shutter dispatch relative to the frame's deadline
+    double captureMs = 0;   // Press to release
+};
+
+struct CaptureSequence {
+    uint64_t id = 0;
+    int cameraIndex = -1;
+    SequenceOptions options;
+    SequenceState state = SequenceState::Scheduled;
+    std::string error;
+
+    int framesCaptured = 0;
+    int framesFailed = 0;
+    double maxLatenessMs = 0;
+    double totalLatenessMs = 0;
+    std::deque<SequenceFrame> recentFrames;  // Last kRecentFrames frames
+
+    std::chrono::system_clock::time_point createdAt;
+    std::chrono::steady_clock::time_point origin;  // Deadline of frame 0
+    std::chrono::steady_clock::time_point pausedAt;
+    bool pauseRequested = false;
+    bool cancelRequested = false;
+
+    bool isFinished() const {
+        return state == SequenceState::Completed || state == SequenceState::Cancelled ||
+               state == SequenceState::Failed;
+    }
+};
+
+// Runs timelapse and burst sequences on the server. Frame n is due at
+// origin + n * interval, so late frames never push back the ones after them.
+// Pausing shifts the origin by the time spent paused.
+class CaptureSequencer {
+public:
+    using CameraLookup = std::function<std::shared_ptr<CameraDeviceWrapper>(int cameraIndex)>;
+    using EventFn = std::function<void(const CameraEvent&)>;
+
+    CaptureSequencer(CameraLookup lookup, CaptureJobTable& jobs, EventFn emit);
+    ~CaptureSequencer();
+
+    // Returns 0 if the camera already runs a sequence
+    uint64_t start(int cameraIndex, const SequenceOptions& options);
+    bool pause(uint64_t id);
+    bool resume(uint64_t id);
+    bool cancel(uint64_t id);
+    void stop();  // Cancel everything and join
+
+    nlohmann::json get(uint64_t id, bool includeFrames = false) const;  // null if unknown
+    nlohmann::json list() const;
+
+    static std::string stateName(SequenceState state);
+
+private:
+    static constexpr size_t kRecentFrames = 256;
+    static constexpr size_t kMaxFinished = 64;
+    // Frames whose camera is gone (e.g. reconnecting) are counted as failed;
+    // this many in a row ends the sequence.
+    static constexpr int kMaxConsecutiveFailures = 50;
+
+    struct Runner {
+        CaptureSequence sequence;  // Guarded by CaptureSequencer::m_mutex
+        std::thread thread;
+    };
+
+    void runSequence(std::shared_ptr<Runner> runner);
+    // Wait until the deadline, or pause/cancel. Returns false when cancelled.
+    bool waitForFrame(std::unique_lock<std::mutex>& lock, CaptureSequence& seq, int frame);
+    void finish(CaptureSequence& seq, SequenceState state, const std::string& error = "");
+    std::vector<std::thread> prune();
+    static nlohmann::json toJson(const CaptureSequence& seq, bool includeFrames);
+
+    CameraLookup m_lookup;
+    CaptureJobTable& m_jobs;
+    EventFn m_emit;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::map<uint64_t, std::shared_ptr<Runner>> m_runners;
+    uint64_t m_nextId{1};
+    bool m_stopping{false};
+};
+
+} // namespace crsdk_rest
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include <vector>
+#include "CameraDeviceWrapper.h"
+
+namespace crsdk_rest {
+
+enum class SessionState {
+    Connected,
+    Degraded,      // Link dropped; giving the SDK's own reconnect a chance
+    Reconnecting,  // Restoring the session with exponential backoff
+    Failed         // Gave up; needs an explicit connect
+};
+
+struct SessionHealth {
+    SessionState state = SessionState::Connected;
+    int attempts = 0;          // Attempts in the current outage
+    int recoveries = 0;        // Outages recovered since connect
+    uint32_t lastError = 0;    // Error code from the last OnDisconnected
+    double lastOutageMs = 0;   // Duration of the last recovered outage
+    std::chrono::steady_clock::time_point stateSince;
+    std::chrono::steady_clock::time_point outageStart;
+    std::chrono::steady_clock::time_point nextAttempt;
+    bool recovering = false;   // A restore is in progress
+    int stalls = 0;            // SDK calls abandoned past their deadline
+};
+
+// Watches connected cameras and restores dropped sessions. Cameras move
+// connected -> degraded on OnDisconnected; if the SDK has not reconnected
+// by the end of the grace period the supervisor reconnects with backoff
+// until it succeeds or runs out of attempts (failed). A camera whose SDK
+// call hangs past its deadline is treated as dropped and reconnected
+// straight away.
+class ConnectionSupervisor {
+public:
+    using RecoverFn = std::function<bool(int cameraIndex)>;
+    using EventFn = std::function<void(const CameraEvent&)>;
+    // Abandons hung SDK calls; returns the cameras that had one
+    using StallCheckFn = std::function<std::vector<int>()>;
+
+    ConnectionSupervisor(RecoverFn recover, EventFn emit, StallCheckFn stallCheck = nullptr);
+    ~ConnectionSupervisor();
+
+    void watch(int cameraIndex);
+    void unwatch(int cameraIndex);
+    void stop();
+
+    void onConnected(int cameraIndex);
+    void onDisconnected(int cameraIndex, uint32_t error);
+
+    nlohmann::json getHealth(int cameraIndex) const;
+    std::string getStateName(int cameraIndex) const;
+    static std::string stateName(SessionState state);
+
+private:
+    static constexpr std::chrono::milliseconds kGracePeriod{2000};
+    static constexpr std::chrono::milliseconds kInitialBackoff{500};
+    static constexpr std::chrono::milliseconds kMaxBackoff{30000};
+    static constexpr int kMaxAttempts = 12;
+    static constexpr std::chrono::milliseconds kStallCheckInterval{250};
+
+    void supervisorLoop();
+    // Called unlocked; marks cameras with an abandoned call degraded
+    void checkStalls();
+    // Caller holds m_mutex; the resulting event is emitted after unlocking
+    void setState(int cameraIndex, SessionHealth& health, SessionState state,
+                  std::vector<CameraEvent>& events);
+
+    RecoverFn m_recover;
+    EventFn m_emit;
+    StallCheckFn m_stallCheck;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::map<int, SessionHealth> m_sessions;
+    bool m_stopping{false};
+    std::thread m_thread;
+};
+
+} // namespace crsdk_rest
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <optional>
+#include <mutex>
+#include <cstdint>
+#include <fstream>
+#include <json.hpp>
+
+namespace crsdk_rest {
+
+struct CachedFile {
+    std::string path;
+    std::string name;  // Original file name on the card; empty for thumbnails
+    uint64_t size = 0;
+    std::string hash;  // Xxh64::format for originals; empty if not known
+};
+
+// Persistent cache of content originals and thumbnails under a byte budget,
+// evicting the least recently used entries. Keys combine the camera
+// identity, content handle and the content's size and modification time,
+// so a reused handle never serves another file. The index file keeps the
+// entries (most recent first) across restarts; inserts and evictions are
+// appended to a journal in between, which is folded into the index once it
+// outgrows it and on close.
+class ContentCache {
+public:
+    enum class Kind { Original, Thumbnail };
+
+    // A zero budget disables the cache
+    bool open(const std::string& dir, uint64_t budgetBytes);
+    void close();  // Persist the last-use order
+    bool isEnabled() const;
+
+    // Empty if the cache is off. modified and size as from
+    // CameraDeviceWrapper::getContentVersion; without them the key only
+    // holds for the camera's current session.
+    std::string keyFor(const std::string& cameraIdentity, uint32_t contentHandle, const std::string& modified,
+                       uint64_t size, Kind kind);
+    // Ends the session keys of a camera; handles are only valid in a session
+    void forgetSession(const std::string& cameraIdentity);
+
+    std::optional<CachedFile> lookup(const std::string& key);
+    // Hard-links the file in (copies across filesystems). With a hash, a
+    // copy is checked against it before it is kept.
+    bool insertFile(const std::string& key, const std::string& sourcePath, const std::string& name,
+                    const std::string& hash = "");
+    bool insertData(const std::string& key, const std::vector<uint8_t>& data);
+
+    nlohmann::json getStats() const;
+
+private:
+    static constexpr const char* kIndexFile = "index.tsv";
+    static constexpr const char* kJournalFile = "journal.tsv";
+    // Journal lines beyond the entry count before it is folded into the index
+    static constexpr size_t kJournalSlack = 256;
+
+    struct Entry {
+        std::string key;
+        std::string file;  // Name inside the cache directory
+        std::string name;
+        uint64_t size = 0;
+        std::string hash;
+    };
+
+    // Index the written file and evict down to the budget
+    bool commit(const std::string& key, const std::string& tmpPath, const std::string& file,
+                const std::string& name, uint64_t size, const std::string& hash);
+    // Both read the same tab separated fields: file, size, name, key, hash
+    static bool parseEntry(std::istream& fields, Entry& entry);
+    bool loadEntry(Entry entry, bool front);  // Caller holds m_mutex
+
+    std::string nextFileName();  // Caller holds m_mutex
+    // Caller holds m_mutex. Appends one insert (or, with file empty, removal)
+    void journal(const Entry& entry);
+    bool persist();  // Caller holds m_mutex; rewrites the index, empties the journal
+
+    mutable std::mutex m_mutex;
+    std::string m_dir;
+    uint64_t m_budget{0};
+    uint64_t m_bytes{0};
+    uint64_t m_nextId{1};
+    std::list<Entry> m_lru;  // Front is the most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> m_entries;
+    std::unordered_map<std::string, std::string> m_sessions;  // Identity -> token of its current session
+    std::ofstream m_journal;
+    size_t m_journalLines{0};
+
+    uint64_t m_hits{0};
+    uint64_t m_misses{0};
+    uint64_t m_evictions{0};
+};
+
+} // namespace crsdk_rest
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <json.hpp>
+
+namespace crsdk_rest {
+
+struct CatalogEntry {
+    uint32_t handle = 0;
+    uint32_t folder = 0;
+    std::string name;
+    uint64_t size = 0;
+    std::string type;      // Upper-case extension: JPG, ARW, HIF, MP4...
+    std::string captured;  // ISO 8601 UTC, empty if the camera gave none
+    std::string hash;      // Xxh64::format of the file, once it has been pulled
+};
+
+struct CatalogQuery {
+    enum class Sort { Date, Name };
+
+    Sort sort = Sort::Date;
+    bool descending = false;
+    std::string type;                // Case-insensitive
+    std::string namePrefix;          // Case-insensitive
+    std::string from;                // Inclusive date or date-time prefixes
+    std::string to;
+    std::optional<uint32_t> folder;
+    size_t limit = 100;
+    std::string cursor;              // nextCursor of the previous page
+};
+
+struct CatalogPage {
+    std::vector<CatalogEntry> items;
+    std::string nextCursor;  // Empty on the last page
+};
+
+// Metadata of every content on one camera's card, indexed by capture time
+// (overall and per type) and by lower-cased name. Pages are keyset
+// cursors, so they stay stable while entries are added.
+class ContentCatalog {
+public:
+    static constexpr size_t kMaxPageSize = 1000;
+
+    // Replace the set of listed contents (handle -> folder). Entries no
+    // longer listed are dropped; returns the listed handles without details.
+    std::vector<uint32_t> setListing(const std::unordered_map<uint32_t, uint32_t>& listing);
+    bool isListed(uint32_t handle) const;
+    bool get(uint32_t handle, CatalogEntry& entry) const;
+    void put(const CatalogEntry& entry);
+    // Kept for the handle until it leaves the listing
+    void setHash(uint32_t handle, const std::string& hash);
+    void clear();
+
+    // False if the cursor is malformed or from another sort order
+    bool query(const CatalogQuery& query, CatalogPage& page) const;
+
+    size_t listedCount() const;
+    size_t size() const;
+
+    // From getContentsDetailInfo's result; false without a name
+    static bool fromDetail(const nlohmann::json& detail, CatalogEntry& entry);
+    static nlohmann::json toJson(const CatalogEntry& entry);
+    static std::string typeFor(const std::string& name);
+    // The camera's timestamp digits (YYYYMMDDhhmmss) as ISO 8601
+    static std::string normalizeTimestamp(const std::string& raw);
+
+private:
+    using Key = std::pair<std::string, uint32_t>;  // Sort key, handle
+
+    void removeLocked(uint32_t handle);
+    static std::string lower(const std::string& s);
+    static std::string encodeCursor(char sort, const Key& key);
+    static bool decodeCursor(const std::string& cursor, char sort, Key& key);
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint32_t, uint32_t> m_listed;
+    std::unordered_map<uint32_t, CatalogEntry> m_entries;
+    std::unordered_map<uint32_t, std::string> m_hashes;  // May arrive before the entry
+    std::map<std::string, std::set<Key>> m_byDate;  // "" holds every type
+    std::set<Key> m_byName;
+};
+
+} // namespace crsdk_rest
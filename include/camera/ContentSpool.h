@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include "util/SingleFlight.h"
+#include "TransferScheduler.h"
+
+namespace crsdk_rest {
+
+class CameraDeviceWrapper;
+
+// An original file pulled from a camera. Its spool directory is deleted
+// with the last reference, so a response still streaming it keeps it.
+struct SpooledFile {
+    std::string dir;
+    std::string path;
+    std::string name;
+    uint64_t size = 0;
+    std::string etag;  // Strong validator: camera identity, handle, size and modification time
+    std::string hash;  // Xxh64::format of the pulled bytes
+
+    ~SpooledFile();
+};
+
+// Scratch directory for original files pulled from cameras. A pulled file is
+// kept for a while after its last use so resumed and ranged downloads are
+// served without pulling it again; concurrent requests share one pull. Every
+// pull is hashed as it lands, while the file is still in the page cache.
+// Kept files are bounded by a byte budget (least recently used go first)
+// and swept once a minute, so the spool shrinks even when nothing is pulled.
+class ContentSpool {
+public:
+    // Called just before a pull starts; the pull runs while the returned
+    // ticket is held. Null gives up on the pull.
+    using Admission = std::function<std::shared_ptr<TransferTicket>()>;
+
+    static constexpr uint64_t kDefaultBudgetBytes = 4ULL * 1024 * 1024 * 1024;
+
+    ~ContentSpool();
+
+    // Create the directory, clear pulls left over from a previous run and
+    // start the sweeper
+    bool open(const std::string& dir, uint64_t budgetBytes = kDefaultBudgetBytes);
+    // Stop the sweeper and drop every kept file
+    void close();
+
+    // The content's original file, pulled unless a recent pull is still
+    // spooled. Returns null on failure. Without retain a fresh pull is
+    // deleted as soon as the caller drops it. Requests joining a pull in
+    // flight share its admission.
+    std::shared_ptr<const SpooledFile> acquire(CameraDeviceWrapper& camera, const std::string& cameraIdentity,
+                                               uint32_t contentHandle, bool retain = true,
+                                               const Admission& admit = nullptr);
+
+    // Drop a camera's spooled files; its content handles may now mean
+    // something else
+    void invalidate(const std::string& cameraIdentity);
+
+    std::string getDirectory() const;
+
+    // modified as from CameraDeviceWrapper::getContentVersion
+    static std::string makeETag(const std::string& cameraIdentity, uint32_t contentHandle, uint64_t size,
+                                const std::string& modified);
+
+private:
+    static constexpr std::chrono::minutes kRetention{15};  // Since last use
+    static constexpr std::chrono::minutes kSweepInterval{1};
+    static constexpr const char* kPullPrefix = "pull-";
+
+    struct Entry {
+        std::shared_ptr<const SpooledFile> file;
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    std::shared_ptr<const SpooledFile> pull(CameraDeviceWrapper& camera, const std::string& cameraIdentity,
+                                            uint32_t contentHandle);
+    // Caller holds m_mutex. Drops expired files, then the least recently
+    // used until the kept files fit the budget; they are handed back to be
+    // released after unlocking.
+    std::vector<std::shared_ptr<const SpooledFile>> sweep();
+    void sweepLoop();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_sweeper;
+    bool m_stopping{false};
+    std::string m_dir;
+    uint64_t m_budget{kDefaultBudgetBytes};
+    uint64_t m_keptBytes{0};
+    uint64_t m_nextId{1};
+    std::map<std::string, Entry> m_entries;  // "<identity>/<handle>"
+    SingleFlight<std::shared_ptr<const SpooledFile>> m_pulls;
+};
+
+} // namespace crsdk_rest
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+namespace crsdk_rest {
+
+// Content-addressed file store under a root directory. Each distinct file is
+// kept once in .objects/ under its hash, and named files are hard links to
+// it, so the same capture offloaded twice (another session, a re-pull after
+// a crash, a second card reader) takes its space once. A manifest remembers
+// which hash every named file was stored with. A name is never taken over
+// by other bytes: cameras reuse file names across folders and cards, so a
+// clash is stored as "<stem>-<n><ext>" next to it instead.
+class ContentStore {
+public:
+    bool open(const std::string& root);
+
+    // The name at dest, or one of its de-collided variants, that was stored
+    // with this hash and still links to its object; empty if none
+    std::string find(const std::string& dest, const std::string& hash) const;
+
+    // Store source's bytes (hash as from Xxh64::format) under dest, or the
+    // first free variant if dest names other bytes; dest is set to the name
+    // used. duplicate is set when the store already had the bytes, so
+    // nothing was copied. Copies are hashed again before they count.
+    bool ingest(const std::string& source, const std::string& hash, uint64_t size, std::string& dest,
+                bool& duplicate, std::string& error);
+
+private:
+    static constexpr const char* kObjectDir = ".objects";
+    static constexpr const char* kManifestFile = ".objects/manifest.tsv";
+    static constexpr int kMaxVariants = 1000;
+
+    struct Record {
+        std::string hash;
+        uint64_t size = 0;
+    };
+
+    std::string objectPath(const std::string& hash) const;
+    // dest for n == 0, else "<stem>-<n><ext>" in the same directory
+    static std::string variant(const std::string& dest, int n);
+    // dest was stored with hash and still links to its object
+    bool names(const std::string& dest, const std::string& hash) const;
+    // Place the object, verifying a copy against its hash
+    bool storeObject(const std::string& source, const std::string& hash, uint64_t size,
+                     const std::string& object, bool& duplicate, std::string& error);
+    // Caller holds m_mutex
+    void record(const std::string& dest, const Record& rec);
+
+    mutable std::mutex m_mutex;
+    std::string m_root;
+    std::unordered_map<std::string, Record> m_manifest;  // By dest path
+};
+
+} // namespace crsdk_rest
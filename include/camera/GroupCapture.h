@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <json.hpp>
+
+namespace crsdk_rest {
+
+class CameraDeviceWrapper;
+
+// One-shot gate for synchronized dispatch. Waiters spin instead of blocking
+// so that opening the gate releases every waiter within a cache-line
+// transfer rather than a scheduler wakeup.
+class SpinGate {
+public:
+    void arrive() { m_arrived.fetch_add(1, std::memory_order_acq_rel); }
+    int arrived() const { return m_arrived.load(std::memory_order_acquire); }
+
+    void open() { m_state.store(kOpen, std::memory_order_release); }
+    void abort() { m_state.store(kAborted, std::memory_order_release); }
+
+    // Returns false if the gate was aborted instead of opened
+    bool wait() const {
+        for (uint32_t spins = 1;; spins++) {
+            int state = m_state.load(std::memory_order_acquire);
+            if (state != kClosed) {
+                return state == kOpen;
+            }
+            // Stay hot, but let other runnable threads in now and then
+            if ((spins & 0x3FF) == 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    static constexpr int kClosed = 0;
+    static constexpr int kOpen = 1;
+    static constexpr int kAborted = 2;
+
+    std::atomic<int> m_arrived{0};
+    std::atomic<int> m_state{kClosed};
+};
+
+// Filled in by the camera's queue thread during a synchronized capture. The
+// coordinator may give up on a camera that is still arming or firing, so
+// the fields below 'finished' are only read once it is set.
+struct ShotTiming {
+    std::atomic<bool> armed{false};
+    std::atomic<bool> halfPressed{false};  // S1 lock taken; without it AF/AE runs after the release
+    std::atomic<bool> finished{false};
+    bool pressed = false;
+    bool released = false;
+    std::chrono::steady_clock::time_point pressSent;  // Just before SendCommand(Down)
+    double pressCallUs = 0;                           // Duration of that call
+};
+
+struct GroupCaptureOptions {
+    static constexpr int kMaxHoldMs = 5000;
+    static constexpr int kMaxArmTimeoutMs = 30000;
+
+    bool halfPress = true;      // Lock S1 (AF/AE) while arming
+    int holdMs = 35;            // Shutter down time
+    int armTimeoutMs = 2000;    // Abort if a camera is not armed by then
+};
+
+// Fires several cameras from one release point. Each camera arms on its own
+// command queue thread, then all of them spin on a shared gate that the
+// coordinator opens once every camera is armed.
+class GroupCapture {
+public:
+    static nlohmann::json run(const std::vector<std::shared_ptr<CameraDeviceWrapper>>& cameras,
+                              const GroupCaptureOptions& options);
+};
+
+} // namespace crsdk_rest
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <json.hpp>
+
+namespace crsdk_rest {
+
+class CameraDeviceWrapper;
+
+struct PropertyPreset {
+    std::string name;
+    std::string model;  // Camera the preset was taken from
+    std::chrono::system_clock::time_point createdAt;
+    std::map<uint32_t, uint64_t> properties;  // Writable code -> value
+};
+
+// Named snapshots of a camera's writable properties, persisted as JSON.
+// Applying a preset sends only the codes whose value differs from the
+// camera's, mode-like properties first so the values that depend on them
+// are accepted.
+class PropertyPresetStore {
+public:
+    // Load presets from path and persist every change back to it
+    bool load(const std::string& path);
+
+    std::optional<PropertyPreset> save(const std::string& name, CameraDeviceWrapper& camera,
+                                       const std::vector<uint32_t>& codes = {});
+    std::optional<PropertyPreset> get(const std::string& name) const;
+    std::vector<PropertyPreset> list() const;
+    bool remove(const std::string& name);
+
+    // Returns null if the preset does not exist
+    nlohmann::json apply(const std::string& name, CameraDeviceWrapper& camera);
+
+    static nlohmann::json toJson(const PropertyPreset& preset, bool includeProperties);
+
+private:
+    // Wait this long for the camera to confirm a mode change before sending
+    // the properties that depend on it
+    static constexpr std::chrono::milliseconds kModeConfirmTimeout{1000};
+
+    static int applyRank(uint32_t code);
+    bool persist() const;  // Caller holds m_mutex
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, PropertyPreset> m_presets;
+    std::string m_path;
+};
+
+} // namespace crsdk_rest
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace crsdk_rest {
+
+// Thumbnails of one camera session in memory, bounded by a byte budget and
+// evicting the least recently used. A zero budget disables it.
+class ThumbnailCache {
+public:
+    void setBudget(size_t bytes);
+    bool isEnabled() const;
+
+    std::optional<std::vector<uint8_t>> get(uint32_t contentHandle);
+    bool contains(uint32_t contentHandle) const;  // Does not count as a use
+    void put(uint32_t contentHandle, const std::vector<uint8_t>& data);
+    void clear();
+
+private:
+    struct Entry {
+        uint32_t handle;
+        std::vector<uint8_t> data;
+    };
+
+    void evict();  // Caller holds m_mutex
+
+    mutable std::mutex m_mutex;
+    size_t m_budget{0};
+    size_t m_bytes{0};
+    std::list<Entry> m_lru;  // Front is the most recently used
+    std::unordered_map<uint32_t, std::list<Entry>::iterator> m_entries;
+};
+
+} // namespace crsdk_rest
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <json.hpp>
+
+namespace crsdk_rest {
+
+enum class TransferClass {
+    Thumbnail,  // Grid thumbnails, single or batched
+    Preview,    // An original someone is looking at right now
+    Original,   // A plain download
+    Bulk        // Archives and offload
+};
+
+class TransferScheduler;
+
+// Admission to one transfer. The slot goes to the next waiter when the
+// ticket is destroyed.
+class TransferTicket {
+public:
+    ~TransferTicket();
+    TransferTicket(const TransferTicket&) = delete;
+    TransferTicket& operator=(const TransferTicket&) = delete;
+
+    std::chrono::milliseconds getWaited() const { return m_waited; }
+
+private:
+    friend class TransferScheduler;
+    TransferTicket(TransferScheduler& owner, int cameraIndex, TransferClass cls, uint64_t id,
+                   std::chrono::milliseconds waited)
+        : m_owner(owner), m_cameraIndex(cameraIndex), m_class(cls), m_id(id), m_waited(waited) {}
+
+    TransferScheduler& m_owner;
+    int m_cameraIndex;
+    TransferClass m_class;
+    uint64_t m_id;
+    std::chrono::milliseconds m_waited;
+};
+
+// Decides which transfer talks to a camera next. Each camera has two pools
+// of slots: one for thumbnail reads and one for file pulls, so a long pull
+// never holds up a thumbnail. Within a pool, waiters are served by
+// start-time fair queuing over (class, client) flows: every client gets its
+// share, and classes get shares by weight, so bulk work keeps moving while
+// interactive requests go first. Cameras are independent.
+class TransferScheduler {
+public:
+    static constexpr int kDefaultReadsPerCamera = 2;
+    static constexpr int kDefaultPullsPerCamera = 1;
+    // How long a request waits for a slot before giving up
+    static constexpr std::chrono::seconds kInteractiveWait{60};
+    static constexpr std::chrono::minutes kBulkWait{30};
+
+    // Applies to every camera, including ones with transfers under way
+    void setLimits(int readsPerCamera, int pullsPerCamera);
+
+    // Block until the transfer may start. Null when the wait ran out, the
+    // scheduler is stopping or cancelled was set; whoever sets it calls
+    // interrupt() so the waiter notices.
+    std::shared_ptr<TransferTicket> acquire(int cameraIndex, const std::string& client, TransferClass cls,
+                                            const std::atomic<bool>* cancelled = nullptr);
+
+    void interrupt();  // Wake every waiter to recheck its cancel flag
+    void stop();       // Wake every waiter empty-handed
+
+    // Running and queued transfers per camera, optionally for one client.
+    // Queue positions count the waiters now ahead; later arrivals with a
+    // larger share may still go first.
+    nlohmann::json getStatus(const std::string& client = "") const;
+
+    static bool parseClass(const std::string& name, TransferClass& cls);
+    static const char* className(TransferClass cls);
+
+private:
+    friend class TransferTicket;
+
+    enum PoolKind { kReads = 0, kPulls = 1 };
+
+    struct Waiter {
+        uint64_t id = 0;
+        std::string client;
+        TransferClass cls = TransferClass::Original;
+        double start = 0;  // Virtual start tag
+        std::chrono::steady_clock::time_point queuedAt;
+        std::chrono::steady_clock::time_point admittedAt;
+        bool admitted = false;
+    };
+
+    struct Pool {
+        int limit = 1;
+        double virtualTime = 0;
+        std::map<std::string, double> lastFinish;  // By flow
+        std::map<uint64_t, std::shared_ptr<Waiter>> queued;
+        std::map<uint64_t, std::shared_ptr<Waiter>> active;
+    };
+
+    struct Lane {
+        Pool pools[2];
+    };
+
+    static PoolKind poolFor(TransferClass cls);
+    static double weightOf(TransferClass cls);
+
+    // Caller holds m_mutex
+    Pool& poolLocked(int cameraIndex, TransferClass cls);
+    void dispatchLocked(Pool& pool);
+    void release(int cameraIndex, TransferClass cls, uint64_t id);
+    void dropIfIdleLocked(int cameraIndex);  // Forget a camera with no transfers
+    static nlohmann::json describe(const Pool& pool, const std::string& client);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    int m_limits[2] = {kDefaultReadsPerCamera, kDefaultPullsPerCamera};
+    std::map<int, Lane> m_lanes;
+    uint64_t m_nextId{1};
+    bool m_stopping{false};
+};
+
+} // namespace crsdk_rest
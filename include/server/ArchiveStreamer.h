@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <ctime>
+
+// Ensure SSL support is disabled in httplib
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+#undef CPPHTTPLIB_OPENSSL_SUPPORT
+#endif
+#include <httplib.h>
+
+namespace crsdk_rest {
+
+class CameraDeviceWrapper;
+
+enum class ArchiveFormat {
+    Zip,  // Stored (uncompressed), ZIP64 where sizes or offsets need it
+    Tar   // POSIX ustar, base-256 sizes above 8 GiB, PAX headers for long names
+};
+
+// Streams camera contents as one archive built on the fly. Each file is
+// pulled into the spool while the one before it is being sent, so at most
+// two pulled files are on disk and memory use is one read chunk. Files that
+// cannot be pulled are left out and listed in a MISSING.txt entry at the end.
+// Pulls are bulk transfers for the given client; a prefetch still running
+// when the client goes away is cancelled and finishes in the background.
+class ArchiveStreamer {
+public:
+    static bool parseFormat(const std::string& name, ArchiveFormat& format);
+    static std::string extensionFor(ArchiveFormat format);
+
+    // Wait for cancelled prefetches; at shutdown, once cameras are disconnected
+    static void drain();
+
+    static void stream(httplib::Response& res, std::shared_ptr<CameraDeviceWrapper> camera,
+                       const std::string& cameraIdentity, const std::string& client,
+                       const std::vector<uint32_t>& handles, ArchiveFormat format);
+};
+
+} // namespace crsdk_rest
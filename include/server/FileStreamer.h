@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <functional>
+
+// Ensure SSL support is disabled in httplib
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+#undef CPPHTTPLIB_OPENSSL_SUPPORT
+#endif
+#include <httplib.h>
+
+namespace crsdk_rest {
+
+// Streams files from disk into a response through a sized content provider.
+// The file is read in fixed chunks with pread, so memory use does not depend
+// on the file size.
+class FileStreamer {
+public:
+    static constexpr size_t kChunkSize = 256 * 1024;
+
+    // Returns false (leaving res untouched) if the file cannot be opened.
+    // onDone runs once the response is finished or the client went away.
+    static bool serveFile(httplib::Response& res, const std::string& path,
+                          const std::string& contentType = "",
+                          std::function<void()> onDone = nullptr);
+
+    // Same, but maps the file and writes straight from the mapping; for
+    // files that are read repeatedly and likely in the page cache
+    static bool serveMapped(httplib::Response& res, const std::string& path,
+                            const std::string& contentType = "");
+
+    static std::string contentTypeFor(const std::string& path);
+};
+
+} // namespace crsdk_rest
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Ensure SSL support is disabled in httplib
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+#undef CPPHTTPLIB_OPENSSL_SUPPORT
+#endif
+#include <httplib.h>
+
+namespace crsdk_rest {
+
+class CameraDeviceWrapper;
+class TransferTicket;
+
+// Streams many thumbnails as one multipart/mixed response. A few reads are
+// kept queued ahead of the one being sent, so the camera works through them
+// back to back while other requests still get a turn between them. Every
+// read from the camera takes its own transfer ticket for the client. Parts
+// go out in request order; a missing thumbnail becomes a JSON error part.
+class ThumbnailBatchStreamer {
+public:
+    static constexpr size_t kMaxHandles = 500;
+    static constexpr size_t kReadAhead = 4;
+
+    // ticket, taken before the response started, serves the first read
+    static void stream(httplib::Response& res, std::shared_ptr<CameraDeviceWrapper> camera,
+                       const std::string& client, const std::vector<uint32_t>& handles,
+                       std::shared_ptr<TransferTicket> ticket);
+
+private:
+    static std::string generateBoundary();
+};
+
+} // namespace crsdk_rest
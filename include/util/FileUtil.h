@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+namespace crsdk_rest {
+
+// Copy a regular file; a partial copy is removed on failure
+bool copyFile(const std::string& from, const std::string& to);
+
+// Hard link to where the file is, falling back to a copy across filesystems
+bool linkOrCopyFile(const std::string& from, const std::string& to);
+
+} // namespace crsdk_rest
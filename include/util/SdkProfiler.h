@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <json.hpp>
+
+namespace crsdk_rest {
+
+// SCRSDK entry points the server calls
+enum class SdkFunction {
+    EnumCameraObjects,
+    Connect,
+    Disconnect,
+    ReleaseDevice,
+    GetDeviceProperties,
+    GetSelectDeviceProperties,
+    SetDeviceProperty,
+    SendCommand,
+    GetLiveViewImageInfo,
+    GetLiveViewImage,
+    GetDateFolderList,
+    GetContentsHandleList,
+    GetContentsDetailInfo,
+    PullContentsFile,
+    GetContentsThumbnailImage,
+    Count
+};
+
+// Latency statistics per SDK function and camera. The hot path is two clock
+// reads and a few relaxed atomic adds; only failed and slow calls take a lock.
+class SdkProfiler {
+public:
+    static SdkProfiler& getInstance();
+
+    // Time sdkCall() and record it. Integral/enum results are treated as CrError
+    // codes (0 = success). arg0/arg1 are kept for the slow-call log.
+    template <typename Call>
+    static auto call(SdkFunction fn, int cameraIndex, uint64_t arg0, uint64_t arg1, Call&& sdkCall)
+        -> decltype(sdkCall()) {
+        auto& profiler = getInstance();
+        if (!profiler.m_enabled.load(std::memory_order_relaxed)) {
+            return sdkCall();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto result = sdkCall();
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        uint32_t error = 0;
+        if constexpr (std::is_enum_v<decltype(result)> || std::is_integral_v<decltype(result)>) {
+            error = static_cast<uint32_t>(result);
+        }
+        profiler.record(fn, cameraIndex, static_cast<uint64_t>(ns), error, arg0, arg1);
+        return result;
+    }
+
+    void record(SdkFunction fn, int cameraIndex, uint64_t ns, uint32_t error, uint64_t arg0, uint64_t arg1);
+
+    void setEnabled(bool enabled) { m_enabled.store(enabled); }
+    bool isEnabled() const { return m_enabled.load(); }
+    void setSlowThresholdMs(int ms) { m_slowThresholdNs.store(static_cast<uint64_t>(ms) * 1000000); }
+
+    nlohmann::json toJson() const;
+    void reset();
+
+    static const char* functionName(SdkFunction fn);
+
+private:
+    SdkProfiler() = default;
+    SdkProfiler(const SdkProfiler&) = delete;
+    SdkProfiler& operator=(const SdkProfiler&) = delete;
+
+    static constexpr int kMaxCameras = 16;  // Higher indices and global calls share the last slot
+    static constexpr int kBuckets = 32;     // Bucket b counts calls of [2^(b-1), 2^b) us
+    static constexpr size_t kSlowCalls = 256;
+    static constexpr size_t kFunctions = static_cast<size_t>(SdkFunction::Count);
+
+    struct alignas(64) CallStats {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> totalNs{0};
+        std::atomic<uint64_t> maxNs{0};
+        std::array<std::atomic<uint64_t>, kBuckets> buckets{};
+    };
+
+    struct SlowCall {
+        SdkFunction fn;
+        int cameraIndex;
+        uint64_t ns;
+        uint32_t error;
+        uint64_t arg0;
+        uint64_t arg1;
+        std::chrono::system_clock::time_point at;
+    };
+
+    static int cameraSlot(int cameraIndex) {
+        return (cameraIndex >= 0 && cameraIndex < kMaxCameras) ? cameraIndex : kMaxCameras;
+    }
+
+    std::atomic<bool> m_enabled{true};
+    std::atomic<uint64_t> m_slowThresholdNs{100000000};  // 100 ms
+    std::array<std::array<CallStats, kMaxCameras + 1>, kFunctions> m_stats;
+
+    // Failed and slow calls only
+    mutable std::mutex m_mutex;
+    std::map<std::pair<size_t, int>, std::map<uint32_t, uint64_t>> m_errorCodes;
+    std::array<SlowCall, kSlowCalls> m_slowCalls{};
+    size_t m_slowCallCount{0};  // Total recorded; ring position is count % kSlowCalls
+};
+
+} // namespace crsdk_rest
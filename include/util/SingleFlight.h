@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace crsdk_rest {
+
+// Coalesces concurrent identical calls: the first caller for a key runs the
+// function, callers arriving while it is in flight wait for and share its
+// result. With a TTL the finished result keeps being served until it
+// expires or the key is invalidated.
+template <typename T>
+class SingleFlight {
+public:
+    T run(const std::string& key, std::chrono::milliseconds ttl, const std::function<T()>& fn) {
+        return runCacheable(key, ttl, [&fn](bool&) { return fn(); });
+    }
+
+    // As run, but fn can clear cacheable to keep a result (a failed read
+    // reported as an empty value) from being served after the call ends
+    T runCacheable(const std::string& key, std::chrono::milliseconds ttl,
+                   const std::function<T(bool& cacheable)>& fn) {
+        std::shared_ptr<Call> call;
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_calls.find(key);
+            if (it != m_calls.end()) {
+                if (!it->second->done || std::chrono::steady_clock::now() < it->second->expires) {
+                    call = it->second;
+                } else {
+                    m_calls.erase(it);
+                }
+            }
+            if (!call) {
+                call = std::make_shared<Call>();
+                call->result = call->promise.get_future().share();
+                m_calls[key] = call;
+                leader = true;
+            }
+        }
+
+        if (!leader) {
+            return call->result.get();
+        }
+
+        bool failed = false;
+        bool cacheable = true;
+        try {
+            call->promise.set_value(fn(cacheable));
+        } catch (...) {
+            call->promise.set_exception(std::current_exception());
+            failed = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            call->done = true;
+            call->expires = std::chrono::steady_clock::now() + ttl;
+
+            // Errors are never cached; the entry may also have been
+            // invalidated (and replaced) while the call was in flight
+            auto it = m_calls.find(key);
+            if (it != m_calls.end() && it->second == call && (failed || !cacheable || ttl.count() <= 0)) {
+                m_calls.erase(it);
+            }
+        }
+        return call->result.get();
+    }
+
+    // Later callers start a fresh call; callers already waiting keep theirs
+    void invalidate(const std::string& key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_calls.erase(key);
+    }
+
+    void invalidatePrefix(const std::string& prefix) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_calls.begin(); it != m_calls.end();) {
+            if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                it = m_calls.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_calls.clear();
+    }
+
+private:
+    struct Call {
+        std::promise<T> promise;
+        std::shared_future<T> result;
+        bool done = false;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, std::shared_ptr<Call>> m_calls;
+};
+
+} // namespace crsdk_rest
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace crsdk_rest {
+
+// Streaming XXH64: fast, non-cryptographic, good at catching corrupted or
+// truncated copies. Feed data in any chunking; the digest is the same.
+class Xxh64 {
+public:
+    explicit Xxh64(uint64_t seed = 0);
+
+    void update(const void* data, size_t size);
+    uint64_t digest() const;
+
+    // Hash a whole file. False if it cannot be read.
+    static bool hashFile(const std::string& path, uint64_t& digest);
+    // "xxh64:" and 16 lower-case hex digits, as shown to clients
+    static std::string format(uint64_t digest);
+
+private:
+    uint64_t m_acc[4];
+    uint64_t m_seed;
+    uint64_t m_total{0};
+    unsigned char m_buffer[32];
+    size_t m_buffered{0};
+};
+
+} // namespace crsdk_rest
@@ -1,9 +1,16 @@
 #include "api/ApiRouter.h"
 #include "api/JsonHelpers.h"
 #include "camera/CameraManager.h"
+#include "camera/BracketCapture.h"
 #include "grbl/GrblController.h"
 #include "server/MjpegStreamer.h"
+#include "server/FileStreamer.h"
+#include "server/ArchiveStreamer.h"
+#include "server/ThumbnailBatchStreamer.h"
+#include "util/SdkProfiler.h"
 #include <iostream>
+#include <optional>
+#include <set>
 
 namespace crsdk_rest {
 
@@ -24,20 +31,41 @@ void ApiRouter::setupRoutes(httplib::Server& server, MjpegStreamer* streamer) {
     // Camera endpoints
     server.Get("/api/v1/cameras", handleListCameras);
     server.Get("/api/v1/cameras/connected", handleConnectedCameras);
+    server.Post("/api/v1/cameras/connect-all", handleConnectAll);
+    server.Post("/api/v1/cameras/group/capture", handleGroupCapture);
     server.Post(R"(/api/v1/cameras/(\d+)/connect)", handleConnectCamera);
     server.Post(R"(/api/v1/cameras/(\d+)/disconnect)", handleDisconnectCamera);
+    server.Get(R"(/api/v1/cameras/(\d+)/health)", handleCameraHealth);
 
     // Property endpoints
     server.Get(R"(/api/v1/cameras/(\d+)/properties)", handleGetProperties);
     server.Put(R"(/api/v1/cameras/(\d+)/properties/(\d+))", handleSetProperty);
 
+    // Preset endpoints
+    server.Get("/api/v1/presets", handleListPresets);
+    server.Get(R"(/api/v1/presets/([\w.-]+))", handleGetPreset);
+    server.Delete(R"(/api/v1/presets/([\w.-]+))", handleDeletePreset);
+    server.Post(R"(/api/v1/cameras/(\d+)/presets/([\w.-]+))", handleSavePreset);
+    server.Post(R"(/api/v1/cameras/(\d+)/presets/([\w.-]+)/apply)", handleApplyPreset);
+
     // Command endpoints
     server.Post(R"(/api/v1/cameras/(\d+)/command)", handleSendCommand);
     server.Post(R"(/api/v1/cameras/(\d+)/capture)", handleCapture);
+    server.Post(R"(/api/v1/cameras/(\d+)/bracket)", handleBracket);
     server.Post(R"(/api/v1/cameras/(\d+)/record/start)", handleRecordStart);
     server.Post(R"(/api/v1/cameras/(\d+)/record/stop)", handleRecordStop);
     server.Post(R"(/api/v1/cameras/(\d+)/focus)", handleFocus);
 
+    // Capture job endpoints
+    server.Get(R"(/api/v1/capture/jobs/(\d+))", handleGetCaptureJob);
+    server.Get(R"(/api/v1/capture/jobs/(\d+)/wait)", handleWaitCaptureJob);
+
+    // Sequence endpoints
+    server.Post(R"(/api/v1/cameras/(\d+)/sequence)", handleStartSequence);
+    server.Get("/api/v1/sequences", handleListSequences);
+    server.Get(R"(/api/v1/sequences/(\d+))", handleGetSequence);
+    server.Post(R"(/api/v1/sequences/(\d+)/(pause|resume|cancel))", handleControlSequence);
+
     // Live view endpoints
     server.Get(R"(/api/v1/cameras/(\d+)/liveview/image)", handleLiveViewImage);
     server.Get(R"(/api/v1/cameras/(\d+)/liveview/info)", handleLiveViewInfo);
@@ -53,9 +81,22 @@ void ApiRouter::setupRoutes(httplib::Server& server, MjpegStreamer* streamer) {
     // Content transfer endpoints
     server.Get(R"(/api/v1/cameras/(\d+)/contents/folders)", handleGetFolders);
     server.Get(R"(/api/v1/cameras/(\d+)/contents/folders/(\d+))", handleGetContents);
+    server.Get(R"(/api/v1/cameras/(\d+)/contents/folders/(\d+)/archive)", handleDownloadArchive);
+    server.Get(R"(/api/v1/cameras/(\d+)/contents/catalog)", handleQueryCatalog);
     server.Get(R"(/api/v1/cameras/(\d+)/contents/(\d+)/info)", handleGetContentInfo);
     server.Get(R"(/api/v1/cameras/(\d+)/contents/(\d+)/download)", handleDownloadContent);
     server.Get(R"(/api/v1/cameras/(\d+)/contents/(\d+)/thumbnail)", handleGetThumbnail);
+    server.Post(R"(/api/v1/cameras/(\d+)/contents/thumbnails)", handleBatchThumbnails);
+    server.Get("/api/v1/transfers", handleListTransfers);
+
+    // Offload endpoints
+    server.Get("/api/v1/offload", handleOffloadStats);
+    server.Put(R"(/api/v1/cameras/(\d+)/offload)", handleSetOffload);
+
+    // Debug endpoints
+    server.Get("/api/v1/debug/sdk-stats", handleSdkStats);
+    server.Delete("/api/v1/debug/sdk-stats", handleResetSdkStats);
+    server.Get("/api/v1/debug/content-cache", handleContentCacheStats);
 
     // GRBL/CNC endpoints
     server.Get("/api/v1/grbl/ports", handleGrblListPorts);
@@ -136,6 +177,12 @@ void ApiRouter::handleListCameras(const httplib::Request& req, httplib::Response
         return;
     }
 
+    // Served from the discovery cache; rescan only when asked to (or when
+    // nothing has been scanned yet)
+    bool refresh = req.has_param("timeout")
+        || (req.has_param("refresh") && req.get_param_value("refresh") != "0")
+        || !manager.hasScanned();
+
     uint8_t timeout = 3;
     if (req.has_param("timeout")) {
         try {
@@ -143,13 +190,14 @@ void ApiRouter::handleListCameras(const httplib::Request& req, httplib::Response
         } catch (...) {}
     }
 
-    auto cameras = manager.enumerateCameras(timeout);
+    auto cameras = refresh ? manager.enumerateCameras(timeout) : manager.getCameraList();
 
     nlohmann::json camerasJson = nlohmann::json::array();
     for (const auto& cam : cameras) {
         nlohmann::json camJson;
         camJson["index"] = cam.index;
         camJson["id"] = cam.id;
+        camJson["identity"] = cam.identity;
         camJson["model"] = cam.model;
         camJson["connectionType"] = cam.connectionType;
         camJson["sshSupported"] = cam.sshSupported;
@@ -171,6 +219,7 @@ void ApiRouter::handleConnectedCameras(const httplib::Request&, httplib::Respons
             camJson["index"] = idx;
             camJson["model"] = camera->getModel();
             camJson["connected"] = camera->isConnected();
+            camJson["session"] = manager.getSessionState(idx);
             camerasJson.push_back(camJson);
         }
     }
@@ -183,6 +232,7 @@ void ApiRouter::handleConnectCamera(const httplib::Request& req, httplib::Respon
 
     int mode = 0;  // Default: Remote
     bool reconnect = true;
+    int timeoutMs = CameraDeviceWrapper::kDefaultConnectTimeoutMs;
 
     if (!req.body.empty()) {
         try {
@@ -196,11 +246,14 @@ void ApiRouter::handleConnectCamera(const httplib::Request& req, httplib::Respon
             if (json.contains("reconnect")) {
                 reconnect = json["reconnect"].get<bool>();
             }
+            if (json.contains("timeoutMs")) {
+                timeoutMs = json["timeoutMs"].get<int>();
+            }
         } catch (...) {}
     }
 
     auto& manager = CameraManager::getInstance();
-    auto camera = manager.connectCamera(cameraIndex, mode, reconnect);
+    auto camera = manager.connectCamera(cameraIndex, mode, reconnect, timeoutMs);
 
     if (camera && camera->isConnected()) {
         nlohmann::json data;
@@ -214,6 +267,51 @@ void ApiRouter::handleConnectCamera(const httplib::Request& req, httplib::Respon
     }
 }
 
+void ApiRouter::handleConnectAll(const httplib::Request& req, httplib::Response& res) {
+    int mode = 0;
+    bool reconnect = true;
+    int timeoutMs = CameraDeviceWrapper::kDefaultConnectTimeoutMs;
+
+    if (!req.body.empty()) {
+        try {
+            auto json = nlohmann::json::parse(req.body);
+            if (json.contains("mode")) {
+                std::string modeStr = json["mode"].get<std::string>();
+                if (modeStr == "contents_transfer" || modeStr == "ContentsTransfer") {
+                    mode = 1;
+                }
+            }
+            if (json.contains("reconnect")) {
+                reconnect = json["reconnect"].get<bool>();
+            }
+            if (json.contains("timeoutMs")) {
+                timeoutMs = json["timeoutMs"].get<int>();
+            }
+        } catch (...) {}
+    }
+
+    auto& manager = CameraManager::getInstance();
+    if (!manager.isInitialized()) {
+        res.status = 400;
+        res.set_content(jsonError(400, "SDK not initialized").dump(), "application/json");
+        return;
+    }
+
+    auto results = manager.connectAll(mode, reconnect, timeoutMs);
+
+    nlohmann::json camerasJson = nlohmann::json::array();
+    for (const auto& result : results) {
+        nlohmann::json camJson;
+        camJson["index"] = result.index;
+        camJson["connected"] = result.connected;
+        camJson["model"] = result.model;
+        camJson["elapsedMs"] = result.elapsedMs;
+        camerasJson.push_back(camJson);
+    }
+
+    res.set_content(jsonSuccess({{"cameras", camerasJson}}).dump(), "application/json");
+}
+
 void ApiRouter::handleDisconnectCamera(const httplib::Request& req, httplib::Response& res) {
     int cameraIndex = std::stoi(req.matches[1]);
 
@@ -223,6 +321,22 @@ void ApiRouter::handleDisconnectCamera(const httplib::Request& req, httplib::Res
     res.set_content(jsonSuccess({{"disconnected", true}}).dump(), "application/json");
 }
 
+void ApiRouter::handleCameraHealth(const httplib::Request& req, httplib::Response& res) {
+    int cameraIndex = std::stoi(req.matches[1]);
+
+    auto& manager = CameraManager::getInstance();
+    auto health = manager.getSessionHealth(cameraIndex);
+
+    if (health.is_null()) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Camera not connected").dump(), "application/json");
+        return;
+    }
+
+    health["index"] = cameraIndex;
+    res.set_content(jsonSuccess(health).dump(), "application/json");
+}
+
 // Property endpoints
 void ApiRouter::handleGetProperties(const httplib::Request& req, httplib::Response& res) {
     int cameraIndex = std::stoi(req.matches[1]);
@@ -288,6 +402,101 @@ void ApiRouter::handleSetProperty(const httplib::Request& req, httplib::Response
     }
 }
 
+// Preset endpoints
+void ApiRouter::handleListPresets(const httplib::Request&, httplib::Response& res) {
+    nlohmann::json presets = nlohmann::json::array();
+    for (const auto& preset : CameraManager::getInstance().getPresets().list()) {
+        presets.push_back(PropertyPresetStore::toJson(preset, false));
+    }
+    res.set_content(jsonSuccess({{"presets", presets}}).dump(), "application/json");
+}
+
+void ApiRouter::handleGetPreset(const httplib::Request& req, httplib::Response& res) {
+    std::string name = req.matches[1];
+
+    auto preset = CameraManager::getInstance().getPresets().get(name);
+    if (!preset) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Preset not found").dump(), "application/json");
+        return;
+    }
+
+    res.set_content(jsonSuccess(PropertyPresetStore::toJson(*preset, true)).dump(), "application/json");
+}
+
+void ApiRouter::handleDeletePreset(const httplib::Request& req, httplib::Response& res) {
+    std::string name = req.matches[1];
+
+    if (!CameraManager::getInstance().getPresets().remove(name)) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Preset not found").dump(), "application/json");
+        return;
+    }
+
+    res.set_content(jsonSuccess({{"deleted", true}}).dump(), "application/json");
+}
+
+void ApiRouter::handleSavePreset(const httplib::Request& req, httplib::Response& res) {
+    int cameraIndex = std::stoi(req.matches[1]);
+    std::string name = req.matches[2];
+
+    auto& manager = CameraManager::getInstance();
+    auto camera = manager.getConnectedCamera(cameraIndex);
+
+    if (!camera) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Camera not connected").dump(), "application/json");
+        return;
+    }
+
+    // Optional subset of codes; default is every writable property
+    std::vector<uint32_t> codes;
+    if (!req.body.empty()) {
+        try {
+            auto json = nlohmann::json::parse(req.body);
+            if (json.contains("codes")) {
+                codes = json["codes"].get<std::vector<uint32_t>>();
+            }
+        } catch (const std::exception& e) {
+            res.status = 400;
+            res.set_content(jsonError(400, std::string("Invalid request: ") + e.what()).dump(), "application/json");
+            return;
+        }
+    }
+
+    auto preset = manager.getPresets().save(name, *camera, codes);
+    if (!preset) {
+        res.status = 500;
+        res.set_content(jsonError(500, "Failed to read camera properties").dump(), "application/json");
+        return;
+    }
+
+    res.set_content(jsonSuccess(PropertyPresetStore::toJson(*preset, false)).dump(), "application/json");
+}
+
+void ApiRouter::handleApplyPreset(const httplib::Request& req, httplib::Response& res) {
+    int cameraIndex = std::stoi(req.matches[1]);
+    std::string name = req.matches[2];
+
+    auto& manager = CameraManager::getInstance();
+    auto camera = manager.getConnectedCamera(cameraIndex);
+
+    if (!camera) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Camera not connected").dump(), "application/json");
+        return;
+    }
+
+    auto result = manager.getPresets().apply(name, *camera);
+    if (result.is_null()) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Preset not found").dump(), "application/json");
+        return;
+    }
+
+    res.set_content(jsonSuccess(result).dump(), "application/json");
+}
+
 // Command endpoints
 void ApiRouter::handleSendCommand(const httplib::Request& req, httplib::Response& res) {
     int cameraIndex = std::stoi(req.matches[1]);
@@ -336,12 +545,364 @@ void ApiRouter::handleCapture(const httplib::Request& req, httplib::Response& re
         return;
     }
 
-    if (camera->capture()) {
-        res.set_content(jsonSuccess({{"captured", true}}).dump(), "application/json");
-    } else {
+    // Every capture is tracked as a job so downloads can be attributed to it
+    auto& jobs = manager.getCaptureJobs();
+    uint64_t jobId = jobs.create(cameraIndex);
+
+    auto released = camera->captureAsync(
+        [&jobs, jobId](bool ok) {
+            if (ok) {
+                jobs.markPressed(jobId);
+            } else {
+                jobs.markFailed(jobId, "Shutter press failed");
+            }
+        },
+        [&jobs, jobId](bool ok) {
+            if (ok) {
+                jobs.markReleased(jobId);
+            } else {
+                jobs.markFailed(jobId, "Shutter release failed");
+            }
+        });
+
+    if (req.has_param("async") && req.get_param_value("async") != "0") {
+        res.status = 202;
+        res.set_content(jsonSuccess({{"jobId", jobId}, {"state", "pending"}}).dump(), "application/json");
+        return;
+    }
+
+    bool returnImage = req.has_param("return") && req.get_param_value("return") == "image";
+    if (!returnImage) {
+        if (released.get()) {
+            res.set_content(jsonSuccess({{"captured", true}, {"jobId", jobId}}).dump(), "application/json");
+        } else {
+            res.status = 500;
+            res.set_content(jsonError(500, "Failed to capture").dump(), "application/json");
+        }
+        return;
+    }
+
+    // Capture-and-return: wait for OnCompleteDownload and stream the saved
+    // file back. The timeout covers the whole capture.
+    int timeoutMs = 10000;
+    if (req.has_param("timeout")) {
+        try {
+            timeoutMs = std::stoi(req.get_param_value("timeout"));
+        } catch (...) {}
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    if (released.wait_until(deadline) != std::future_status::ready) {
+        res.status = 504;
+        res.set_content(jsonError(504, "Capture timed out").dump(), "application/json");
+        return;
+    }
+    if (!released.get()) {
         res.status = 500;
         res.set_content(jsonError(500, "Failed to capture").dump(), "application/json");
+        return;
     }
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    auto job = jobs.waitFor(jobId, std::max(remaining, std::chrono::milliseconds(0)));
+    if (!job || job->state == CaptureJobState::Failed) {
+        res.status = 500;
+        res.set_content(jsonError(500, job ? job->error : "Capture job lost").dump(), "application/json");
+        return;
+    }
+    if (job->state != CaptureJobState::Downloaded) {
+        // The image may still arrive; the job can be polled
+        res.status = 504;
+        auto error = jsonError(504, "Timed out waiting for the image");
+        error["data"] = CaptureJobTable::toJson(*job);
+        res.set_content(error.dump(), "application/json");
+        return;
+    }
+
+    if (!FileStreamer::serveFile(res, job->filename)) {
+        res.status = 500;
+        res.set_content(jsonError(500, "Captured file not readable: " + job->filename).dump(), "application/json");
+        return;
+    }
+
+    auto slash = job->filename.find_last_of('/');
+    std::string basename = slash == std::string::npos ? job->filename : job->filename.substr(slash + 1);
+    res.set_header("Content-Disposition", "inline; filename=\"" + basename + "\"");
+    res.set_header("X-Capture-Job-Id", std::to_string(jobId));
+}
+
+void ApiRouter::handleGroupCapture(const httplib::Request& req, httplib::Response& res) {
+    auto& manager = CameraManager::getInstance();
+
+    std::vector<int> indices;
+    GroupCaptureOptions options;
+
+    if (!req.body.empty()) {
+        try {
+            auto json = nlohmann::json::parse(req.body);
+            if (json.contains("cameras")) {
+                indices = json["cameras"].get<std::vector<int>>();
+            }
+            if (json.contains("halfPress")) {
+                options.halfPress = json["halfPress"].get<bool>();
+            }
+            if (json.contains("holdMs")) {
+                options.holdMs = json["holdMs"].get<int>();
+            }
+            if (json.contains("armTimeoutMs")) {
+                options.armTimeoutMs = json["armTimeoutMs"].get<int>();
+            }
+        } catch (const std::exception& e) {
+            res.status = 400;
+            res.set_content(jsonError(400, std::string("Invalid request: ") + e.what()).dump(), "application/json");
+            return;
+        }
+    }
+
+    if (options.holdMs < 0 || options.holdMs > GroupCaptureOptions::kMaxHoldMs) {
+        res.status = 400;
+        res.set_content(jsonError(400, "holdMs must be 0 to " +
+                                       std::to_string(GroupCaptureOptions::kMaxHoldMs)).dump(),
+                        "application/json");
+        return;
+    }
+    if (options.armTimeoutMs <= 0 || options.armTimeoutMs > GroupCaptureOptions::kMaxArmTimeoutMs) {
+        res.status = 400;
+        res.set_content(jsonError(400, "armTimeoutMs must be 1 to " +
+                                       std::to_string(GroupCaptureOptions::kMaxArmTimeoutMs)).dump(),
+                        "application/json");
+        return;
+    }
+
+    // A camera listed twice would wait behind itself on its own queue, so
+    // the group could never arm
+    std::set<int> unique(indices.begin(), indices.end());
+    if (unique.size() != indices.size()) {
+        res.status = 400;
+        res.set_content(jsonError(400, "cameras lists a camera more than once").dump(), "application/json");
+        return;
+    }
+
+    // Default group: every connected camera
+    if (indices.empty()) {
+        indices = manager.getConnectedCameraIndices();
+    }
+
+    std::vector<std::shared_ptr<CameraDeviceWrapper>> cameras;
+    for (int idx : indices) {
+        auto camera = manager.getConnectedCamera(idx);
+        if (!camera) {
+            res.status = 404;
+            res.set_content(jsonError(404, "Camera " + std::to_string(idx) + " not connected").dump(), "application/json");
+            return;
+        }
+        cameras.push_back(camera);
+    }
+
+    if (cameras.empty()) {
+        res.status = 404;
+        res.set_content(jsonError(404, "No cameras connected").dump(), "application/json");
+        return;
+    }
+
+    auto result = GroupCapture::run(cameras, options);
+    if (result["captured"].get<bool>()) {
+        res.set_content(jsonSuccess(result).dump(), "application/json");
+    } else {
+        res.status = 500;
+        auto error = jsonError(500, result.value("error", "Group capture failed"));
+        error["data"] = result;
+        res.set_content(error.dump(), "application/json");
+    }
+}
+
+void ApiRouter::handleGetCaptureJob(const httplib::Request& req, httplib::Response& res) {
+    uint64_t jobId = std::stoull(req.matches[1]);
+
+    auto job = CameraManager::getInstance().getCaptureJobs().get(jobId);
+    if (!job) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Capture job not found").dump(), "application/json");
+        return;
+    }
+
+    res.set_content(jsonSuccess(CaptureJobTable::toJson(*job)).dump(), "application/json");
+}
+
+void ApiRouter::handleWaitCaptureJob(const httplib::Request& req, httplib::Response& res) {
+    uint64_t jobId = std::stoull(req.matches[1]);
+
+    int timeoutMs = 10000;
+    if (req.has_param("timeout")) {
+        try {
+            timeoutMs = std::stoi(req.get_param_value("timeout"));
+        } catch (...) {}
+    }
+
+    auto job = CameraManager::getInstance().getCaptureJobs().waitFor(
+        jobId, std::chrono::milliseconds(timeoutMs));
+    if (!job) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Capture job not found").dump(), "application/json");
+        return;
+    }
+
+    auto data = CaptureJobTable::toJson(*job);
+    data["completed"] = job->isFinished();
+    res.set_content(jsonSuccess(data).dump(), "application/json");
+}
+
+void ApiRouter::handleBracket(const httplib::Request& req, httplib::Response& res) {
+    int cameraIndex = std::stoi(req.matches[1]);
+
+    auto& manager = CameraManager::getInstance();
+    auto camera = manager.getConnectedCamera(cameraIndex);
+
+    if (!camera) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Camera not connected").dump(), "application/json");
+        return;
+    }
+
+    std::vector<BracketCapture::Step> steps;
+    BracketOptions options;
+
+    try {
+        auto json = nlohmann::json::parse(req.body);
+        // Each step maps property codes (decimal or "0x..." strings) to values
+        for (const auto& stepJson : json["steps"]) {
+            BracketCapture::Step step;
+            for (const auto& item : stepJson.items()) {
+                auto code = static_cast<uint32_t>(std::stoul(item.key(), nullptr, 0));
+                step[code] = item.value().get<uint64_t>();
+            }
+            steps.push_back(step);
+        }
+        if (json.contains("confirmTimeoutMs")) {
+            options.confirmTimeoutMs = json["confirmTimeoutMs"].get<int>();
+        }
+        if (json.contains("requireConfirm")) {
+            options.requireConfirm = json["requireConfirm"].get<bool>();
+        }
+        if (json.contains("restore")) {
+            options.restore = json["restore"].get<bool>();
+        }
+    } catch (const std::exception& e) {
+        res.status = 400;
+        res.set_content(jsonError(400, std::string("Invalid request: ") + e.what()).dump(), "application/json");
+        return;
+    }
+
+    if (steps.empty()) {
+        res.status = 400;
+        res.set_content(jsonError(400, "No bracket steps given").dump(), "application/json");
+        return;
+    }
+
+    auto result = BracketCapture::run(camera, steps, options, manager.getCaptureJobs());
+    if (result["completed"].get<bool>()) {
+        res.set_content(jsonSuccess(result).dump(), "application/json");
+    } else {
+        res.status = 500;
+        auto error = jsonError(500, result.value("error", "Bracket failed"));
+        error["data"] = result;
+        res.set_content(error.dump(), "application/json");
+    }
+}
+
+// Sequence endpoints
+void ApiRouter::handleStartSequence(const httplib::Request& req, httplib::Response& res) {
+    int cameraIndex = std::stoi(req.matches[1]);
+
+    auto& manager = CameraManager::getInstance();
+    auto camera = manager.getConnectedCamera(cameraIndex);
+
+    if (!camera) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Camera not connected").dump(), "application/json");
+        return;
+    }
+
+    SequenceOptions options;
+    try {
+        auto json = nlohmann::json::parse(req.body);
+        options.count = json["count"].get<int>();
+        if (json.contains("intervalMs")) {
+            options.intervalMs = json["intervalMs"].get<int>();
+        }
+        if (json.contains("startAt")) {
+            options.startAt = json["startAt"].get<int64_t>();
+        }
+    } catch (const std::exception& e) {
+        res.status = 400;
+        res.set_content(jsonError(400, std::string("Invalid request: ") + e.what()).dump(), "application/json");
+        return;
+    }
+
+    if (options.count <= 0 || options.intervalMs < 0) {
+        res.status = 400;
+        res.set_content(jsonError(400, "count must be positive and intervalMs non-negative").dump(), "application/json");
+        return;
+    }
+
+    uint64_t sequenceId = manager.getSequencer().start(cameraIndex, options);
+    if (sequenceId == 0) {
+        res.status = 409;
+        res.set_content(jsonError(409, "Camera already runs a sequence").dump(), "application/json");
+        return;
+    }
+
+    res.status = 202;
+    res.set_content(jsonSuccess(manager.getSequencer().get(sequenceId)).dump(), "application/json");
+}
+
+void ApiRouter::handleListSequences(const httplib::Request&, httplib::Response& res) {
+    auto sequences = CameraManager::getInstance().getSequencer().list();
+    res.set_content(jsonSuccess({{"sequences", sequences}}).dump(), "application/json");
+}
+
+void ApiRouter::handleGetSequence(const httplib::Request& req, httplib::Response& res) {
+    uint64_t sequenceId = std::stoull(req.matches[1]);
+    bool includeFrames = req.has_param("frames") && req.get_param_value("frames") != "0";
+
+    auto sequence = CameraManager::getInstance().getSequencer().get(sequenceId, includeFrames);
+    if (sequence.is_null()) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Sequence not found").dump(), "application/json");
+        return;
+    }
+
+    res.set_content(jsonSuccess(sequence).dump(), "application/json");
+}
+
+void ApiRouter::handleControlSequence(const httplib::Request& req, httplib::Response& res) {
+    uint64_t sequenceId = std::stoull(req.matches[1]);
+    std::string action = req.matches[2];
+
+    auto& sequencer = CameraManager::getInstance().getSequencer();
+    if (sequencer.get(sequenceId).is_null()) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Sequence not found").dump(), "application/json");
+        return;
+    }
+
+    bool ok = false;
+    if (action == "pause") {
+        ok = sequencer.pause(sequenceId);
+    } else if (action == "resume") {
+        ok = sequencer.resume(sequenceId);
+    } else {
+        ok = sequencer.cancel(sequenceId);
+    }
+
+    if (!ok) {
+        res.status = 409;
+        res.set_content(jsonError(409, "Cannot " + action + " sequence in its current state").dump(), "application/json");
+        return;
+    }
+
+    res.set_content(jsonSuccess(sequencer.get(sequenceId)).dump(), "application/json");
 }
 
 void ApiRouter::handleRecordStart(const httplib::Request& req, httplib::Response& res) {
@@ -523,15 +1084,173 @@ void ApiRouter::handleDownloadContent(const httplib::Request& req, httplib::Resp
         return;
     }
 
-    // For now, return thumbnail as a simple implementation
-    auto imageData = camera->getThumbnail(contentHandle);
-    if (imageData.empty()) {
+    std::string identity = manager.getCameraIdentity(cameraIndex);
+    auto& cache = manager.getContentCache();
+    // One version lookup serves both the cache key and the ETag
+    std::string modified;
+    uint64_t listedSize = 0;
+    camera->getContentVersion(contentHandle, modified, listedSize);
+    std::string key = cache.keyFor(identity, contentHandle, modified, listedSize, ContentCache::Kind::Original);
+
+    if (!key.empty()) {
+        if (auto hit = cache.lookup(key)) {
+            if (applyValidators(req, res, ContentSpool::makeETag(identity, contentHandle, hit->size, modified))) {
+                return;
+            }
+            // Evicted since the lookup: fall through and pull it again
+            if (FileStreamer::serveMapped(res, hit->path, FileStreamer::contentTypeFor(hit->name))) {
+                res.set_header("Content-Disposition", "attachment; filename=\"" + hit->name + "\"");
+                if (!hit->hash.empty()) {
+                    res.set_header("X-Content-Hash", hit->hash);
+                }
+                return;
+            }
+        }
+    }
+
+    TransferClass cls = TransferClass::Original;
+    if (req.has_param("priority") &&
+        (!TransferScheduler::parseClass(req.get_param_value("priority"), cls) || cls == TransferClass::Thumbnail)) {
+        res.status = 400;
+        res.set_content(jsonError(400, "priority must be preview, original or bulk").dump(), "application/json");
+        return;
+    }
+
+    // Only an actual pull waits for a slot; spooled files go straight out
+    std::optional<std::chrono::milliseconds> waited;
+    bool queueTimedOut = false;
+    auto file = manager.getSpool().acquire(*camera, identity, contentHandle, true, [&]() {
+        auto ticket = manager.getTransfers().acquire(cameraIndex, clientFor(req), cls);
+        if (ticket) {
+            waited = ticket->getWaited();
+        }
+        queueTimedOut = ticket == nullptr;
+        return ticket;
+    });
+    if (!file) {
+        if (queueTimedOut) {
+            replyQueueFull(res);
+            return;
+        }
         res.status = 404;
-        res.set_content(jsonError(404, "Content not found").dump(), "application/json");
+        res.set_content(jsonError(404, "Content not found or transfer failed").dump(), "application/json");
         return;
     }
+    if (waited) {
+        res.set_header("X-Queue-Wait-Ms", std::to_string(waited->count()));
+    }
+    if (!key.empty()) {
+        cache.insertFile(key, file->path, file->name, file->hash);
+    }
 
-    res.set_content(reinterpret_cast<const char*>(imageData.data()), imageData.size(), "image/jpeg");
+    if (applyValidators(req, res, file->etag)) {
+        return;
+    }
+
+    // The lambda holds the spooled file until the response is done with it
+    if (!FileStreamer::serveFile(res, file->path, "", [file]() {})) {
+        res.status = 500;
+        res.set_content(jsonError(500, "Could not read transferred file").dump(), "application/json");
+        return;
+    }
+    res.set_header("Content-Disposition", "attachment; filename=\"" + file->name + "\"");
+    res.set_header("X-Content-Hash", file->hash);
+}
+
+void ApiRouter::handleDownloadArchive(const httplib::Request& req, httplib::Response& res) {
+    int cameraIndex = std::stoi(req.matches[1]);
+    uint32_t folderHandle = static_cast<uint32_t>(std::stoul(req.matches[2]));
+
+    auto& manager = CameraManager::getInstance();
+    auto camera = manager.getConnectedCamera(cameraIndex);
+
+    if (!camera) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Camera not connected").dump(), "application/json");
+        return;
+    }
+
+    ArchiveFormat format;
+    if (!ArchiveStreamer::parseFormat(req.get_param_value("format"), format)) {
+        res.status = 400;
+        res.set_content(jsonError(400, "format must be zip or tar").dump(), "application/json");
+        return;
+    }
+
+    auto contents = camera->getContentsHandleList(folderHandle);
+    if (contents.empty()) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Folder not found or empty").dump(), "application/json");
+        return;
+    }
+    std::vector<uint32_t> handles = contents.get<std::vector<uint32_t>>();
+
+    std::string name = "folder-" + std::to_string(folderHandle);
+    for (const auto& folder : camera->getDateFolderList()) {
+        if (folder.value("handle", 0u) == folderHandle && folder.contains("name")) {
+            name = folder["name"].get<std::string>();
+            break;
+        }
+    }
+
+    ArchiveStreamer::stream(res, camera, manager.getCameraIdentity(cameraIndex), clientFor(req), handles, format);
+    res.set_header("Content-Disposition",
+                   "attachment; filename=\"" + name + "." + ArchiveStreamer::extensionFor(format) + "\"");
+}
+
+void ApiRouter::handleQueryCatalog(const httplib::Request& req, httplib::Response& res) {
+    int cameraIndex = std::stoi(req.matches[1]);
+
+    auto camera = CameraManager::getInstance().getConnectedCamera(cameraIndex);
+    if (!camera) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Camera not connected").dump(), "application/json");
+        return;
+    }
+
+    CatalogQuery query;
+    std::string sort = req.get_param_value("sort");
+    std::string order = req.get_param_value("order");
+    if ((!sort.empty() && sort != "date" && sort != "name") || (!order.empty() && order != "asc" && order != "desc")) {
+        res.status = 400;
+        res.set_content(jsonError(400, "sort must be date or name, order asc or desc").dump(), "application/json");
+        return;
+    }
+    query.sort = sort == "name" ? CatalogQuery::Sort::Name : CatalogQuery::Sort::Date;
+    query.descending = order == "desc";
+    query.type = req.get_param_value("type");
+    query.namePrefix = req.get_param_value("name");
+    query.from = req.get_param_value("from");
+    query.to = req.get_param_value("to");
+    query.cursor = req.get_param_value("cursor");
+    try {
+        if (req.has_param("folder")) {
+            query.folder = static_cast<uint32_t>(std::stoul(req.get_param_value("folder")));
+        }
+        if (req.has_param("limit")) {
+            query.limit = static_cast<size_t>(std::stoul(req.get_param_value("limit")));
+        }
+    } catch (const std::exception&) {
+        res.status = 400;
+        res.set_content(jsonError(400, "folder and limit must be numbers").dump(), "application/json");
+        return;
+    }
+
+    CatalogPage page;
+    if (!camera->queryCatalog(query, page)) {
+        res.status = 400;
+        res.set_content(jsonError(400, "Invalid cursor").dump(), "application/json");
+        return;
+    }
+
+    nlohmann::json items = nlohmann::json::array();
+    for (const auto& entry : page.items) {
+        items.push_back(ContentCatalog::toJson(entry));
+    }
+    nlohmann::json data = camera->getCatalogStatus();
+    data["items"] = items;
+    data["nextCursor"] = page.nextCursor.empty() ? nlohmann::json() : nlohmann::json(page.nextCursor);
+    res.set_content(jsonSuccess(data).dump(), "application/json");
 }
 
 void ApiRouter::handleGetThumbnail(const httplib::Request& req, httplib::Response& res) {
@@ -547,16 +1266,170 @@ void ApiRouter::handleGetThumbnail(const httplib::Request& req, httplib::Respons
         return;
     }
 
+    // Prefetched thumbnails are answered without asking the camera anything
+    if (auto cached = camera->getCachedThumbnail(contentHandle)) {
+        res.set_content(reinterpret_cast<const char*>(cached->data()), cached->size(), "image/jpeg");
+        return;
+    }
+
+    // Keyed from the catalog when it has the content; a detail read would
+    // cost as much as the thumbnail itself
+    auto& cache = manager.getContentCache();
+    std::string modified;
+    uint64_t listedSize = 0;
+    camera->getCatalogedVersion(contentHandle, modified, listedSize);
+    std::string key = cache.keyFor(manager.getCameraIdentity(cameraIndex), contentHandle, modified, listedSize,
+                                   ContentCache::Kind::Thumbnail);
+    if (!key.empty()) {
+        if (auto hit = cache.lookup(key)) {
+            if (FileStreamer::serveMapped(res, hit->path, "image/jpeg")) {
+                return;
+            }
+        }
+    }
+
+    auto ticket = manager.getTransfers().acquire(cameraIndex, clientFor(req), TransferClass::Thumbnail);
+    if (!ticket) {
+        replyQueueFull(res);
+        return;
+    }
     auto imageData = camera->getThumbnail(contentHandle);
+    ticket.reset();
     if (imageData.empty()) {
         res.status = 404;
         res.set_content(jsonError(404, "Thumbnail not found").dump(), "application/json");
         return;
     }
+    if (!key.empty()) {
+        cache.insertData(key, imageData);
+    }
 
     res.set_content(reinterpret_cast<const char*>(imageData.data()), imageData.size(), "image/jpeg");
 }
 
+void ApiRouter::handleBatchThumbnails(const httplib::Request& req, httplib::Response& res) {
+    int cameraIndex = std::stoi(req.matches[1]);
+
+    auto camera = CameraManager::getInstance().getConnectedCamera(cameraIndex);
+    if (!camera) {
+        res.status = 404;
+        res.set_content(jsonError(404, "Camera not connected").dump(), "application/json");
+        return;
+    }
+
+    std::vector<uint32_t> handles;
+    try {
+        auto json = nlohmann::json::parse(req.body);
+        handles = json.at("handles").get<std::vector<uint32_t>>();
+    } catch (const std::exception& e) {
+        res.status = 400;
+        res.set_content(jsonError(400, std::string("Invalid request: ") + e.what()).dump(), "application/json");
+        return;
+    }
+
+    if (handles.empty() || handles.size() > ThumbnailBatchStreamer::kMaxHandles) {
+        res.status = 400;
+        res.set_content(jsonError(400, "handles must list 1 to " +
+                                       std::to_string(ThumbnailBatchStreamer::kMaxHandles) + " contents").dump(),
+                        "application/json");
+        return;
+    }
+
+    // Only the first read waits here, so a full queue still gets a 503; the
+    // rest take their tickets one by one as the batch streams
+    std::string client = clientFor(req);
+    auto ticket = CameraManager::getInstance().getTransfers().acquire(cameraIndex, client,
+                                                                      TransferClass::Thumbnail);
+    if (!ticket) {
+        replyQueueFull(res);
+        return;
+    }
+    ThumbnailBatchStreamer::stream(res, camera, client, handles, ticket);
+}
+
+void ApiRouter::handleListTransfers(const httplib::Request& req, httplib::Response& res) {
+    auto status = CameraManager::getInstance().getTransfers().getStatus(req.get_param_value("client"));
+    status["client"] = clientFor(req);
+    res.set_content(jsonSuccess(status).dump(), "application/json");
+}
+
+std::string ApiRouter::clientFor(const httplib::Request& req) {
+    std::string client = req.get_header_value("X-Client-Id");
+    return client.empty() ? req.remote_addr : client;
+}
+
+void ApiRouter::replyQueueFull(httplib::Response& res) {
+    res.status = 503;
+    res.set_header("Retry-After", "5");
+    res.set_content(jsonError(503, "Camera is busy with other transfers; try again").dump(), "application/json");
+}
+
+// Offload endpoints
+void ApiRouter::handleOffloadStats(const httplib::Request&, httplib::Response& res) {
+    res.set_content(jsonSuccess(CameraManager::getInstance().getOffload().getStats()).dump(), "application/json");
+}
+
+void ApiRouter::handleSetOffload(const httplib::Request& req, httplib::Response& res) {
+    int cameraIndex = std::stoi(req.matches[1]);
+
+    bool enabled = true;
+    try {
+        auto json = nlohmann::json::parse(req.body);
+        enabled = json.at("enabled").get<bool>();
+    } catch (const std::exception& e) {
+        res.status = 400;
+        res.set_content(jsonError(400, std::string("Invalid request: ") + e.what()).dump(), "application/json");
+        return;
+    }
+
+    auto& offload = CameraManager::getInstance().getOffload();
+    if (!offload.isEnabled()) {
+        res.status = 409;
+        res.set_content(jsonError(409, "Offload is off; start the server with --offload-dir").dump(),
+                        "application/json");
+        return;
+    }
+
+    offload.setCameraEnabled(cameraIndex, enabled);
+    res.set_content(jsonSuccess({{"camera", cameraIndex}, {"enabled", enabled}}).dump(), "application/json");
+}
+
+bool ApiRouter::applyValidators(const httplib::Request& req, httplib::Response& res, const std::string& etag) {
+    res.set_header("ETag", etag);
+    res.set_header("Accept-Ranges", "bytes");
+
+    std::string ifNoneMatch = req.get_header_value("If-None-Match");
+    if (!ifNoneMatch.empty() && (ifNoneMatch == "*" || ifNoneMatch.find(etag) != std::string::npos)) {
+        res.status = 304;
+        return true;
+    }
+
+    // A partial copy of another version gets the whole file instead of the
+    // ranges it asked for (RFC 9110 13.1.5). httplib applies req.ranges to
+    // the response itself; the Request it hands handlers is its own
+    // non-const object, so clearing them here is well-defined. A date is
+    // never a match, since no Last-Modified is sent.
+    if (req.has_header("If-Range") && req.get_header_value("If-Range") != etag) {
+        const_cast<httplib::Request&>(req).ranges.clear();
+    }
+    return false;
+}
+
+// Debug endpoints
+void ApiRouter::handleSdkStats(const httplib::Request&, httplib::Response& res) {
+    res.set_content(jsonSuccess(SdkProfiler::getInstance().toJson()).dump(), "application/json");
+}
+
+void ApiRouter::handleResetSdkStats(const httplib::Request&, httplib::Response& res) {
+    SdkProfiler::getInstance().reset();
+    res.set_content(jsonSuccess({{"reset", true}}).dump(), "application/json");
+}
+
+void ApiRouter::handleContentCacheStats(const httplib::Request&, httplib::Response& res) {
+    auto stats = CameraManager::getInstance().getContentCache().getStats();
+    res.set_content(jsonSuccess(stats).dump(), "application/json");
+}
+
 // GRBL/CNC endpoints
 void ApiRouter::handleGrblListPorts(const httplib::Request&, httplib::Response& res) {
     auto& grbl = GrblController::getInstance();
@@ -0,0 +1,398 @@
+#include "camera/AutoOffload.h"
+#include "util/Xxh64.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <iostream>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace crsdk_rest {
+
+AutoOffload::AutoOffload(CameraLookup lookup, ContentSpool& spool, TransferScheduler& transfers, EventFn emit)
+    : m_lookup(std::move(lookup))
+    , m_spool(spool)
+    , m_transfers(transfers)
+    , m_emit(std::move(emit))
+{
+}
+
+AutoOffload::~AutoOffload() {
+    stop();
+}
+
+bool AutoOffload::open(const std::string& dir, double maxMbps) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (dir.empty()) {
+        std::cout << "[AutoOffload] Disabled\n";
+        return true;
+    }
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "[AutoOffload] Could not create " << dir << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    if (!m_store.open(dir)) {
+        return false;
+    }
+
+    m_dir = dir;
+    m_maxBytesPerSec = std::max(maxMbps, 0.0) * 1000000.0 / 8.0;
+    std::cout << "[AutoOffload] Copying new captures to " << m_dir;
+    if (maxMbps > 0) {
+        std::cout << " at up to " << maxMbps << " Mbit/s";
+    }
+    std::cout << "\n";
+    return true;
+}
+
+void AutoOffload::stop() {
+    std::vector<std::shared_ptr<Lane>> lanes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        for (auto& pair : m_lanes) {
+            pair.second->queue.clear();
+            lanes.push_back(pair.second);
+        }
+    }
+    m_cv.notify_all();
+
+    for (auto& lane : lanes) {
+        if (lane->thread.joinable()) {
+            lane->thread.join();
+        }
+    }
+}
+
+bool AutoOffload::isEnabled() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_dir.empty();
+}
+
+void AutoOffload::setCameraEnabled(int cameraIndex, bool enabled) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (enabled) {
+        m_disabled.erase(cameraIndex);
+    } else {
+        m_disabled.insert(cameraIndex);
+    }
+
+    auto it = m_lanes.find(cameraIndex);
+    if (it != m_lanes.end()) {
+        it->second->enabled = enabled;
+        if (!enabled) {
+            it->second->queue.clear();
+            it->second->seen.clear();
+        }
+    }
+    m_cv.notify_all();
+}
+
+void AutoOffload::onNewContent(int cameraIndex, const std::string& cameraIdentity, uint32_t contentHandle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto lane = laneFor(cameraIndex, cameraIdentity);
+    if (!lane || !lane->seen.insert(contentHandle).second) {
+        return;
+    }
+    lane->queue.push_back(Item{contentHandle, ""});
+    m_cv.notify_all();
+}
+
+void AutoOffload::onCapturedFile(int cameraIndex, const std::string& cameraIdentity, const std::string& path) {
+    if (path.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto lane = laneFor(cameraIndex, cameraIdentity);
+    if (!lane) {
+        return;
+    }
+    lane->queue.push_back(Item{0, path});
+    m_cv.notify_all();
+}
+
+void AutoOffload::onDisconnected(int cameraIndex) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_lanes.find(cameraIndex);
+    if (it == m_lanes.end()) {
+        return;
+    }
+
+    // Files already saved on this host are still good
+    auto& queue = it->second->queue;
+    queue.erase(std::remove_if(queue.begin(), queue.end(),
+                               [](const Item& item) { return item.hostPath.empty(); }),
+                queue.end());
+    it->second->seen.clear();
+    m_cv.notify_all();
+}
+
+nlohmann::json AutoOffload::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    nlohmann::json stats;
+    stats["enabled"] = !m_dir.empty();
+    stats["directory"] = m_dir;
+    stats["maxMbps"] = m_maxBytesPerSec * 8.0 / 1000000.0;
+
+    nlohmann::json cameras = nlohmann::json::array();
+    for (const auto& [index, lane] : m_lanes) {
+        nlohmann::json camera;
+        camera["camera"] = index;
+        camera["enabled"] = lane->enabled;
+        camera["directory"] = lane->dir;
+        camera["state"] = lane->state;
+        camera["current"] = lane->current ? nlohmann::json(lane->current) : nlohmann::json();
+        camera["queued"] = lane->queue.size();
+        camera["completed"] = lane->completed;
+        camera["skipped"] = lane->skipped;
+        camera["deduplicated"] = lane->deduplicated;
+        camera["failed"] = lane->failed;
+        camera["bytes"] = lane->bytes;
+        camera["transferMs"] = lane->transferMs;
+        camera["throttledMs"] = lane->throttledMs;
+        camera["throughputBps"] = lane->transferMs > 0 ? lane->bytes * 1000.0 / lane->transferMs : 0.0;
+        camera["lastFile"] = lane->lastFile;
+        camera["lastError"] = lane->lastError;
+        cameras.push_back(camera);
+    }
+    stats["cameras"] = cameras;
+
+    nlohmann::json disabled = nlohmann::json::array();
+    for (int index : m_disabled) {
+        disabled.push_back(index);
+    }
+    stats["disabledCameras"] = disabled;
+    return stats;
+}
+
+std::shared_ptr<AutoOffload::Lane> AutoOffload::laneFor(int cameraIndex, const std::string& cameraIdentity) {
+    if (m_dir.empty() || m_stopping || m_disabled.count(cameraIndex) != 0) {
+        return nullptr;
+    }
+
+    auto it = m_lanes.find(cameraIndex);
+    if (it != m_lanes.end()) {
+        return it->second;
+    }
+
+    auto lane = std::make_shared<Lane>();
+    lane->cameraIndex = cameraIndex;
+    lane->identity = cameraIdentity;
+    lane->dir = m_dir + "/" + sanitize(cameraIdentity.empty() ? "camera-" + std::to_string(cameraIndex)
+                                                              : cameraIdentity);
+    if (mkdir(lane->dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "[AutoOffload] Could not create " << lane->dir << ": " << std::strerror(errno) << "\n";
+    }
+
+    // Copies cut short by a previous run
+    if (DIR* handle = opendir(lane->dir.c_str())) {
+        std::string suffix = kPartialSuffix;
+        while (dirent* entry = readdir(handle)) {
+            std::string name = entry->d_name;
+            if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                unlink((lane->dir + "/" + name).c_str());
+            }
+        }
+        closedir(handle);
+    }
+
+    m_lanes[cameraIndex] = lane;
+    lane->thread = std::thread(&AutoOffload::runLane, this, lane);
+    return lane;
+}
+
+void AutoOffload::runLane(std::shared_ptr<Lane> lane) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_cv.wait(lock, [&]() { return m_stopping || !lane->queue.empty(); });
+        if (m_stopping || !waitForQuiet(lock, *lane)) {
+            break;
+        }
+        if (lane->queue.empty()) {
+            continue;  // Dropped by a disconnect while waiting
+        }
+
+        Item item = lane->queue.front();
+        lane->queue.pop_front();
+        lane->state = "transferring";
+        lane->current = item.handle;
+        std::string identity = lane->identity;
+        std::string dir = lane->dir;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        Outcome outcome;
+        transfer(lane->cameraIndex, identity, dir, item, outcome);
+        uint64_t bytes = outcome.bytes;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        CameraEvent event;
+        if (!outcome.skipped) {
+            event = CameraEvent(outcome.error.empty() ? "offload_complete" : "offload_failed", lane->cameraIndex);
+            event.data = {{"handle", item.handle}, {"file", outcome.dest}};
+            if (outcome.error.empty()) {
+                event.data["size"] = bytes;
+                event.data["ms"] = ms;
+                event.data["hash"] = outcome.hash;
+                event.data["deduplicated"] = outcome.duplicate;
+            } else {
+                event.data["error"] = outcome.error;
+                std::cerr << "[AutoOffload] Camera " << lane->cameraIndex << ": " << outcome.error << "\n";
+            }
+            if (m_emit) {
+                m_emit(event);
+            }
+        }
+
+        lock.lock();
+        lane->current = 0;
+        if (outcome.skipped) {
+            lane->skipped++;
+        } else if (outcome.error.empty()) {
+            lane->completed++;
+            lane->deduplicated += outcome.duplicate ? 1 : 0;
+            lane->bytes += bytes;
+            lane->transferMs += ms;
+            lane->lastFile = outcome.dest;
+        } else {
+            lane->failed++;
+            lane->lastError = outcome.error;
+        }
+
+        // Under a cap, each file holds the lane for its share of the bandwidth
+        if (m_maxBytesPerSec > 0 && bytes > 0) {
+            auto share = std::chrono::duration<double>(static_cast<double>(bytes) / m_maxBytesPerSec);
+            auto until = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(share);
+            if (until > std::chrono::steady_clock::now()) {
+                lane->state = "throttled";
+                m_cv.wait_until(lock, until, [&]() { return m_stopping; });
+            }
+        }
+        lane->state = "idle";
+    }
+    lane->state = "idle";
+}
+
+bool AutoOffload::waitForQuiet(std::unique_lock<std::mutex>& lock, Lane& lane) {
+    auto deferUntil = std::chrono::steady_clock::now() + kMaxDefer;
+    while (!m_stopping) {
+        // Files already on this host do not touch the camera
+        if (lane.queue.empty() || !lane.queue.front().hostPath.empty()) {
+            return true;
+        }
+
+        lock.unlock();
+        auto camera = m_lookup(lane.cameraIndex);
+        auto idle = camera ? camera->getIdleTime() : kQuietPeriod;
+        lock.lock();
+
+        auto now = std::chrono::steady_clock::now();
+        if (idle >= kQuietPeriod || now >= deferUntil) {
+            return true;
+        }
+
+        lane.state = "throttled";
+        auto wake = std::min(now + (kQuietPeriod - idle), deferUntil);
+        m_cv.wait_until(lock, wake, [&]() { return m_stopping || lane.queue.empty(); });
+        lane.throttledMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - now).count();
+    }
+    return false;
+}
+
+void AutoOffload::transfer(int cameraIndex, const std::string& identity, const std::string& dir,
+                           const Item& item, Outcome& outcome) {
+    if (!item.hostPath.empty()) {
+        struct stat st;
+        if (stat(item.hostPath.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            outcome.error = "Saved file not found: " + item.hostPath;
+            return;
+        }
+        outcome.dest = dir + "/" + sanitize(item.hostPath.substr(item.hostPath.find_last_of('/') + 1));
+        uint64_t size = static_cast<uint64_t>(st.st_size);
+        uint64_t digest = 0;
+        if (!Xxh64::hashFile(item.hostPath, digest)) {
+            outcome.error = "Could not read " + item.hostPath;
+            return;
+        }
+        outcome.hash = Xxh64::format(digest);
+        std::string stored = m_store.find(outcome.dest, outcome.hash);
+        if (!stored.empty()) {
+            outcome.dest = stored;
+            outcome.skipped = true;
+            return;
+        }
+        if (m_store.ingest(item.hostPath, outcome.hash, size, outcome.dest, outcome.duplicate, outcome.error)) {
+            outcome.bytes = size;
+        }
+        return;
+    }
+
+    auto camera = m_lookup(cameraIndex);
+    if (!camera) {
+        outcome.error = "Camera not connected";
+        return;
+    }
+
+    try {
+        auto detail = camera->getContentsDetailInfo(item.handle);
+        std::string name = detail.is_object() ? detail.value("fileName", "") : "";
+        if (name.empty()) {
+            outcome.error = "Content " + std::to_string(item.handle) + " not found";
+            return;
+        }
+        outcome.dest = dir + "/" + sanitize(name);
+        uint64_t expected = detail.value("size", static_cast<uint64_t>(0));
+        // Names repeat across folders and cards, so only a known hash can
+        // tell that the file is already here without pulling it
+        std::string known = camera->getContentHash(item.handle);
+        std::string stored = known.empty() ? "" : m_store.find(outcome.dest, known);
+        if (!stored.empty()) {
+            outcome.dest = stored;
+            outcome.hash = known;
+            outcome.skipped = true;
+            return;
+        }
+
+        bool admitted = true;
+        auto file = m_spool.acquire(*camera, identity, item.handle, false, [&]() {
+            auto ticket = m_transfers.acquire(cameraIndex, kClientName, TransferClass::Bulk);
+            admitted = ticket != nullptr;
+            return ticket;
+        });
+        if (!file) {
+            outcome.error = admitted ? "Transfer of " + name + " failed" : "No transfer slot for " + name;
+            return;
+        }
+        // A file shorter than the camera says was cut off on the way
+        if (expected != 0 && file->size != expected) {
+            outcome.error = "Transfer of " + name + " gave " + std::to_string(file->size) + " of " +
+                            std::to_string(expected) + " bytes";
+            return;
+        }
+
+        outcome.hash = file->hash;
+        if (m_store.ingest(file->path, file->hash, file->size, outcome.dest, outcome.duplicate, outcome.error)) {
+            outcome.bytes = file->size;
+        }
+    } catch (const std::exception& e) {
+        outcome.error = e.what();
+    }
+}
+
+std::string AutoOffload::sanitize(const std::string& name) {
+    std::string out;
+    for (char c : name) {
+        bool safe = std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-' || c == '_';
+        out += safe ? c : '_';
+    }
+    if (out.empty() || out == "." || out == "..") {
+        out = "_";
+    }
+    return out;
+}
+
+} // namespace crsdk_rest
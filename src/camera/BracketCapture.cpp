@@ -0,0 +1,189 @@
+#include "camera/BracketCapture.h"
+#include "camera/CameraDeviceWrapper.h"
+#include "camera/CaptureJobTable.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace crsdk_rest {
+
+namespace {
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Current values of the given codes as reported by the camera
+std::map<uint32_t, uint64_t> readValues(CameraDeviceWrapper& camera, const std::vector<uint32_t>& codes) {
+    std::map<uint32_t, uint64_t> values;
+    for (const auto& prop : camera.getSelectProperties(codes)) {
+        values[prop["code"].get<uint32_t>()] = prop["currentValue"].get<uint64_t>();
+    }
+    return values;
+}
+
+} // namespace
+
+nlohmann::json BracketCapture::run(const std::shared_ptr<CameraDeviceWrapper>& camera,
+                                   const std::vector<Step>& steps,
+                                   const BracketOptions& options,
+                                   CaptureJobTable& jobs) {
+    auto bracketStart = std::chrono::steady_clock::now();
+
+    std::vector<uint32_t> allCodes;
+    for (const auto& step : steps) {
+        for (const auto& pair : step) {
+            if (std::find(allCodes.begin(), allCodes.end(), pair.first) == allCodes.end()) {
+                allCodes.push_back(pair.first);
+            }
+        }
+    }
+
+    // What the camera holds now; steps only send codes that differ from it
+    auto original = readValues(*camera, allCodes);
+    auto known = original;
+
+    nlohmann::json stepResults = nlohmann::json::array();
+    bool completed = true;
+    std::string error;
+
+    for (size_t i = 0; i < steps.size() && completed; i++) {
+        auto stepStart = std::chrono::steady_clock::now();
+        nlohmann::json result;
+        result["step"] = i;
+
+        // Set every differing code first, then wait for all confirmations
+        std::map<uint32_t, uint64_t> pending;
+        std::map<uint32_t, uint64_t> seqs;
+        nlohmann::json changed = nlohmann::json::array();
+        for (const auto& pair : steps[i]) {
+            auto it = known.find(pair.first);
+            if (it != known.end() && it->second == pair.second) {
+                continue;
+            }
+            seqs[pair.first] = camera->getPropertyChangeSeq(pair.first);
+            if (!camera->setProperty(pair.first, pair.second)) {
+                completed = false;
+                error = "Failed to set property " + std::to_string(pair.first);
+                break;
+            }
+            pending[pair.first] = pair.second;
+            changed.push_back(pair.first);
+        }
+        result["changed"] = changed;
+        result["setMs"] = msSince(stepStart);
+        if (!completed) {
+            result["error"] = error;
+            stepResults.push_back(result);
+            break;
+        }
+
+        auto confirmStart = std::chrono::steady_clock::now();
+        auto deadline = confirmStart + std::chrono::milliseconds(options.confirmTimeoutMs);
+        while (!pending.empty()) {
+            auto waitCode = pending.begin()->first;
+            if (!camera->waitForPropertyChange(waitCode, seqs[waitCode], deadline)) {
+                break;
+            }
+
+            // A change notification is not necessarily the value we asked
+            // for; read back and keep waiting for the codes that disagree
+            std::vector<uint32_t> codes;
+            for (const auto& pair : pending) {
+                codes.push_back(pair.first);
+                seqs[pair.first] = camera->getPropertyChangeSeq(pair.first);
+            }
+            auto current = readValues(*camera, codes);
+            for (auto it = pending.begin(); it != pending.end();) {
+                auto value = current.find(it->first);
+                if (value != current.end() && value->second == it->second) {
+                    known[it->first] = it->second;
+                    it = pending.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        result["confirmMs"] = msSince(confirmStart);
+        result["confirmed"] = pending.empty();
+
+        if (!pending.empty()) {
+            nlohmann::json unconfirmed = nlohmann::json::array();
+            for (const auto& pair : pending) {
+                unconfirmed.push_back(pair.first);
+                known.erase(pair.first);  // Unknown now; always resend
+            }
+            result["unconfirmed"] = unconfirmed;
+            if (options.requireConfirm) {
+                completed = false;
+                error = "Camera did not confirm the properties of step " + std::to_string(i);
+                result["error"] = error;
+                stepResults.push_back(result);
+                break;
+            }
+        }
+
+        auto captureStart = std::chrono::steady_clock::now();
+        uint64_t jobId = jobs.create(camera->getIndex());
+        auto released = camera->captureAsync(
+            [&jobs, jobId](bool ok) {
+                if (ok) {
+                    jobs.markPressed(jobId);
+                } else {
+                    jobs.markFailed(jobId, "Shutter press failed");
+                }
+            },
+            [&jobs, jobId](bool ok) {
+                if (ok) {
+                    jobs.markReleased(jobId);
+                } else {
+                    jobs.markFailed(jobId, "Shutter release failed");
+                }
+            });
+
+        bool captured = false;
+        try {
+            captured = released.get();
+        } catch (const std::exception& e) {
+            jobs.markFailed(jobId, e.what());
+        }
+        result["jobId"] = jobId;
+        result["captured"] = captured;
+        result["captureMs"] = msSince(captureStart);
+        result["totalMs"] = msSince(stepStart);
+        stepResults.push_back(result);
+
+        if (!captured) {
+            completed = false;
+            error = "Capture failed at step " + std::to_string(i);
+        }
+    }
+
+    // Restore without waiting; nothing is shot with these values
+    bool restored = false;
+    if (options.restore) {
+        restored = true;
+        for (const auto& pair : original) {
+            auto it = known.find(pair.first);
+            if (it != known.end() && it->second == pair.second) {
+                continue;
+            }
+            restored = camera->setProperty(pair.first, pair.second) && restored;
+        }
+    }
+
+    nlohmann::json summary;
+    summary["completed"] = completed;
+    summary["steps"] = stepResults;
+    summary["restored"] = restored;
+    summary["totalMs"] = msSince(bracketStart);
+    if (!error.empty()) {
+        summary["error"] = error;
+    }
+
+    std::cout << "[Camera " << camera->getIndex() << "] Bracket of " << steps.size() << " steps "
+              << (completed ? "completed" : "stopped") << " in " << summary["totalMs"].get<double>() << " ms\n";
+    return summary;
+}
+
+} // namespace crsdk_rest
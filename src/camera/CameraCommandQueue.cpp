@@ -0,0 +1,152 @@
+#include "camera/CameraCommandQueue.h"
+#include <iostream>
+
+namespace crsdk_rest {
+
+CameraCommandQueue::CameraCommandQueue(int cameraIndex)
+    : m_state(std::make_shared<State>())
+{
+    m_state->cameraIndex = cameraIndex;
+    m_worker = std::thread(&CameraCommandQueue::workerLoop, m_state, uint64_t(0));
+}
+
+CameraCommandQueue::~CameraCommandQueue() {
+    stop();
+}
+
+std::chrono::milliseconds CameraCommandQueue::defaultTimeout(CommandPriority priority) {
+    switch (priority) {
+        case CommandPriority::Control: return std::chrono::milliseconds(10000);
+        case CommandPriority::PropertySet: return std::chrono::milliseconds(5000);
+        case CommandPriority::PropertyRead: return std::chrono::milliseconds(5000);
+        case CommandPriority::Content: return std::chrono::milliseconds(30000);
+        case CommandPriority::Background: return std::chrono::milliseconds(30000);
+    }
+    return std::chrono::milliseconds(10000);
+}
+
+bool CameraCommandQueue::abandonStalledWorker() {
+    std::function<void(std::exception_ptr)> failRunning;
+    std::thread stuck;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (!m_state->running || m_state->stopping ||
+            std::chrono::steady_clock::now() < m_state->deadline) {
+            return false;
+        }
+
+        failRunning = std::move(m_state->failRunning);
+        m_state->running = false;
+        m_state->generation++;
+        m_state->abandoned++;
+
+        stuck = std::move(m_worker);
+        m_worker = std::thread(&CameraCommandQueue::workerLoop, m_state, m_state->generation);
+    }
+
+    // The stuck thread exits on its own if the SDK call ever returns
+    stuck.detach();
+    if (failRunning) {
+        failRunning(std::make_exception_ptr(SdkTimeoutError(
+            m_state->cameraIndex, "Camera " + std::to_string(m_state->cameraIndex) + " SDK call timed out")));
+    }
+
+    std::cerr << "[Camera " << m_state->cameraIndex << "] SDK call overran its deadline; worker abandoned\n";
+    return true;
+}
+
+void CameraCommandQueue::stop() {
+    std::thread worker;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->stopping = true;
+        if (!isWorkerThread()) {
+            worker = std::move(m_worker);
+        } else if (m_worker.joinable()) {
+            // The owner is being torn down by its own queued work; the
+            // worker drains and exits on its own, holding the shared state
+            m_worker.detach();
+        }
+    }
+    m_state->cv.notify_all();
+
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+size_t CameraCommandQueue::pending() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->queue.size();
+}
+
+uint64_t CameraCommandQueue::abandonedWorkers() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->abandoned;
+}
+
+bool CameraCommandQueue::workerAbandoned() const {
+    if (!isWorkerThread()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->generation != t_workerGeneration;
+}
+
+std::chrono::steady_clock::time_point CameraCommandQueue::lastInteractive() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->lastInteractive;
+}
+
+void CameraCommandQueue::workerLoop(std::shared_ptr<State> state, uint64_t generation) {
+    t_workerState = state.get();
+    t_workerGeneration = generation;
+
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->cv.wait(lock, [&]() {
+                return state->stopping || !state->queue.empty() || state->generation != generation;
+            });
+
+            // Replaced while waiting; the new worker owns the queue
+            if (state->generation != generation) {
+                return;
+            }
+
+            // Queued work is still run on stop so no caller is left waiting
+            if (state->queue.empty()) {
+                break;
+            }
+
+            task = state->queue.top();
+            state->queue.pop();
+
+            // The caller gave up before the work started
+            if (task.settled->load()) {
+                continue;
+            }
+
+            state->running = true;
+            state->deadline = std::chrono::steady_clock::now() + task.timeout;
+            state->failRunning = task.fail;
+        }
+
+        try {
+            task.run();
+        } catch (const std::exception& e) {
+            std::cerr << "[Camera " << state->cameraIndex << "] Queued command failed: " << e.what() << "\n";
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->generation != generation) {
+            std::cerr << "[Camera " << state->cameraIndex << "] Abandoned SDK call returned\n";
+            return;
+        }
+        state->running = false;
+        state->failRunning = nullptr;
+    }
+}
+
+} // namespace crsdk_rest
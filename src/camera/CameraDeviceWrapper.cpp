@@ -1,6 +1,8 @@
 #include "camera/CameraDeviceWrapper.h"
 #include "CameraRemote_SDK.h"
 #include "CrDeviceProperty.h"
+#include "util/SdkProfiler.h"
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -12,10 +14,13 @@ namespace SDK = SCRSDK;
 CameraDeviceWrapper::CameraDeviceWrapper(
     int index,
     SDK::ICrCameraObjectInfo* info,
+    std::shared_ptr<void> infoOwner,
     std::function<void(const CameraEvent&)> eventCallback)
     : m_index(index)
     , m_info(info)
+    , m_infoOwner(std::move(infoOwner))
     , m_eventCallback(eventCallback)
+    , m_queue(index)
 {
     // Get model name
     if (info) {
@@ -31,14 +36,577 @@ CameraDeviceWrapper::CameraDeviceWrapper(
 }
 
 CameraDeviceWrapper::~CameraDeviceWrapper() {
-    if (m_connected.load()) {
-        disconnect();
+    // Queued work holds a reference, so nothing else can be using the
+    // session now; close it directly, possibly on the queue thread itself
+    if (m_connected.load() || m_handle.load() != 0) {
+        sdkDisconnect();
+    }
+    m_queue.stop();
+}
+
+// Public operations are submitted to the camera's command queue so that all
+// SDK calls for this device run on its executor thread in priority order.
+// The sdk* implementations below must only be called from that thread.
+// Queued work holds a reference to the wrapper: a caller that times out
+// returns, but the task may still run later.
+
+// Connection calls report a missed deadline as a failure like any other;
+// the supervisor decides what to do with the camera.
+
+bool CameraDeviceWrapper::connect(int mode, bool reconnect, int timeoutMs) {
+    try {
+        return m_queue.run<bool>(CommandPriority::Control, [this, self = shared_from_this(), mode, reconnect, timeoutMs]() {
+            return sdkConnect(mode, reconnect, timeoutMs);
+        }, std::chrono::milliseconds(timeoutMs + kConnectDeadlineSlackMs));
+    } catch (const SdkTimeoutError& e) {
+        std::cerr << "[Camera " << m_index << "] Connect: " << e.what() << "\n";
+        return false;
+    }
+}
+
+bool CameraDeviceWrapper::restoreSession(SDK::ICrCameraObjectInfo* info, std::shared_ptr<void> infoOwner,
+                                         int timeoutMs) {
+    try {
+        return m_queue.run<bool>(CommandPriority::Control, [this, self = shared_from_this(), info, infoOwner, timeoutMs]() {
+            // Drop the dead handle, then reopen with the original settings
+            sdkDisconnect();
+
+            if (info) {
+                m_info = info;
+                m_infoOwner = infoOwner;
+            }
+
+            if (!sdkConnect(m_mode, m_reconnect, timeoutMs)) {
+                return false;
+            }
+
+            std::map<uint32_t, uint64_t> properties;
+            {
+                std::lock_guard<std::mutex> lock(m_appliedMutex);
+                properties = m_appliedProperties;
+            }
+
+            for (const auto& pair : properties) {
+                if (!sdkSetProperty(pair.first, pair.second)) {
+                    std::cerr << "[Camera " << m_index << "] Could not reapply property 0x"
+                              << std::hex << pair.first << std::dec << "\n";
+                }
+            }
+
+            std::cout << "[Camera " << m_index << "] Session restored, reapplied "
+                      << properties.size() << " properties\n";
+            return true;
+        }, std::chrono::milliseconds(timeoutMs + kRestoreDeadlineSlackMs));
+    } catch (const SdkTimeoutError& e) {
+        std::cerr << "[Camera " << m_index << "] Restore: " << e.what() << "\n";
+        return false;
+    }
+}
+
+nlohmann::json CameraDeviceWrapper::getAppliedProperties() const {
+    std::lock_guard<std::mutex> lock(m_appliedMutex);
+
+    nlohmann::json result = nlohmann::json::object();
+    for (const auto& pair : m_appliedProperties) {
+        result[std::to_string(pair.first)] = pair.second;
     }
+    return result;
+}
+
+uint64_t CameraDeviceWrapper::getPropertyChangeSeq(uint32_t code) const {
+    std::lock_guard<std::mutex> lock(m_propertyChangeMutex);
+    auto it = m_propertyChangeSeq.find(code);
+    return m_propertyChangeAll + (it != m_propertyChangeSeq.end() ? it->second : 0);
+}
+
+bool CameraDeviceWrapper::waitForPropertyChange(uint32_t code, uint64_t sinceSeq,
+                                                std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(m_propertyChangeMutex);
+    return m_propertyChangeCv.wait_until(lock, deadline, [this, code, sinceSeq]() {
+        auto it = m_propertyChangeSeq.find(code);
+        return m_propertyChangeAll + (it != m_propertyChangeSeq.end() ? it->second : 0) != sinceSeq;
+    });
+}
+
+bool CameraDeviceWrapper::disconnect() {
+    try {
+        return m_queue.run<bool>(CommandPriority::Control, [this, self = shared_from_this()]() {
+            return sdkDisconnect();
+        });
+    } catch (const SdkTimeoutError& e) {
+        std::cerr << "[Camera " << m_index << "] Disconnect: " << e.what() << "\n";
+        return false;
+    }
+}
+
+bool CameraDeviceWrapper::abandonStalledCall() {
+    if (m_queue.abandonStalledWorker()) {
+        emitEvent("sdk_timeout", {{"abandonedWorkers", m_queue.abandonedWorkers()}});
+        return true;
+    }
+
+    // Live view runs on the HTTP thread that asked, so there is no worker to
+    // replace; the frame is reported once, and the reconnect that follows
+    // leaves its handle to be released when the call returns
+    auto started = m_liveViewStarted.load();
+    if (started == 0) {
+        return false;
+    }
+    auto running = std::chrono::steady_clock::now() -
+                   std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(started));
+    if (running < std::chrono::milliseconds(kLiveViewDeadlineMs) || m_liveViewStallReported.exchange(true)) {
+        return false;
+    }
+    std::cerr << "[Camera " << m_index << "] Live view frame overran its deadline\n";
+    emitEvent("sdk_timeout", {{"abandonedWorkers", m_queue.abandonedWorkers()}, {"liveView", true}});
+    return true;
+}
+
+nlohmann::json CameraDeviceWrapper::getAllProperties() {
+    return coalescedRead<nlohmann::json>(m_reads, "properties", CommandPriority::PropertyRead, [this](bool& ok) {
+        return sdkGetAllProperties(&ok);
+    });
+}
+
+nlohmann::json CameraDeviceWrapper::getSelectProperties(const std::vector<uint32_t>& codes) {
+    std::string key = "properties:";
+    for (auto code : codes) {
+        key += std::to_string(code) + ",";
+    }
+    return coalescedRead<nlohmann::json>(m_reads, key, CommandPriority::PropertyRead, [this, codes](bool& ok) {
+        return sdkGetSelectProperties(codes, &ok);
+    });
+}
+
+bool CameraDeviceWrapper::setProperty(uint32_t code, uint64_t value) {
+    return m_queue.run<bool>(CommandPriority::PropertySet, [this, self = shared_from_this(), code, value]() {
+        return sdkSetProperty(code, value);
+    });
+}
+
+bool CameraDeviceWrapper::sendCommand(uint32_t commandId, uint32_t param) {
+    return m_queue.run<bool>(CommandPriority::Control, [this, self = shared_from_this(), commandId, param]() {
+        return sdkSendCommand(commandId, param);
+    });
+}
+
+bool CameraDeviceWrapper::capture() {
+    return captureAsync().get();
+}
+
+std::shared_future<bool> CameraDeviceWrapper::captureAsync(
+    std::function<void(bool)> onPressed,
+    std::function<void(bool)> onReleased) {
+    // Press and release as one task so nothing is interleaved between them
+    return m_queue.submit<bool>(CommandPriority::Control, [this, self = shared_from_this(), onPressed, onReleased]() {
+        bool pressed = sdkSendCommand(SDK::CrCommandId_Release, SDK::CrCommandParam_Down);
+        if (onPressed) {
+            onPressed(pressed);
+        }
+        if (!pressed) {
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(35));
+
+        bool released = sdkSendCommand(SDK::CrCommandId_Release, SDK::CrCommandParam_Up);
+        if (onReleased) {
+            onReleased(released);
+        }
+        return released;
+    });
+}
+
+std::shared_future<bool> CameraDeviceWrapper::synchronizedCapture(
+    std::shared_ptr<SpinGate> gate,
+    std::shared_ptr<ShotTiming> timing,
+    bool halfPress,
+    int holdMs,
+    int armTimeoutMs) {
+    // The gate may stay shut for the whole arm timeout and the shutter is
+    // held down on top of the SDK calls themselves
+    auto deadline = CameraCommandQueue::defaultTimeout(CommandPriority::Control) +
+                    std::chrono::milliseconds(armTimeoutMs + holdMs);
+    return m_queue.submit<bool>(CommandPriority::Control, [this, self = shared_from_this(), gate, timing, halfPress, holdMs]() {
+        // Arm: pre-focus/meter so the release only has to trip the shutter
+        // A camera that refuses S1 still fires, but is reported unsynchronized
+        if (halfPress) {
+            timing->halfPressed.store(sdkSetS1Lock(true));
+        }
+
+        timing->armed.store(true);
+        gate->arrive();
+
+        bool fire = gate->wait();
+        if (fire) {
+            timing->pressSent = std::chrono::steady_clock::now();
+            timing->pressed = sdkSendCommand(SDK::CrCommandId_Release, SDK::CrCommandParam_Down);
+            timing->pressCallUs = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - timing->pressSent).count();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(holdMs));
+            timing->released = sdkSendCommand(SDK::CrCommandId_Release, SDK::CrCommandParam_Up);
+        }
+
+        if (timing->halfPressed.load()) {
+            sdkSetS1Lock(false);
+        }
+        timing->finished.store(true);
+        return fire && timing->pressed && timing->released;
+    }, deadline);
+}
+
+bool CameraDeviceWrapper::startRecording() {
+    return sendCommand(SDK::CrCommandId_MovieRecord, SDK::CrCommandParam_Down);
+}
+
+bool CameraDeviceWrapper::stopRecording() {
+    return sendCommand(SDK::CrCommandId_MovieRecord, SDK::CrCommandParam_Up);
+}
+
+bool CameraDeviceWrapper::halfPressShutter() {
+    return sendCommand(SDK::CrCommandId_Release, SDK::CrCommandParam_Down);
 }
 
-bool CameraDeviceWrapper::connect(int mode, bool reconnect) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+bool CameraDeviceWrapper::releaseShutter() {
+    return sendCommand(SDK::CrCommandId_Release, SDK::CrCommandParam_Up);
+}
+
+nlohmann::json CameraDeviceWrapper::getLiveViewInfo() {
+    return coalescedRead<nlohmann::json>(m_reads, "liveview_info", CommandPriority::PropertyRead, [this](bool& ok) {
+        return sdkGetLiveViewInfo(&ok);
+    });
+}
+
+nlohmann::json CameraDeviceWrapper::getDateFolderList() {
+    return coalescedRead<nlohmann::json>(m_reads, "folders", CommandPriority::Content, [this](bool& ok) {
+        return sdkGetDateFolderList(&ok);
+    });
+}
+
+nlohmann::json CameraDeviceWrapper::getContentsHandleList(uint32_t folderHandle) {
+    auto handles = coalescedRead<nlohmann::json>(m_reads, "contents:" + std::to_string(folderHandle),
+                                                 CommandPriority::Content, [this, folderHandle](bool& ok) {
+        return sdkGetContentsHandleList(folderHandle, &ok);
+    });
+    startPrefetch(folderHandle, handles);
+    return handles;
+}
+
+nlohmann::json CameraDeviceWrapper::getContentsDetailInfo(uint32_t contentHandle) {
+    auto detail = coalescedRead<nlohmann::json>(m_reads, "detail:" + std::to_string(contentHandle),
+                                                CommandPriority::Content, [this, contentHandle](bool& ok) {
+        return sdkGetContentsDetailInfo(contentHandle, &ok);
+    });
+
+    // Saves the catalog a read of its own
+    CatalogEntry entry;
+    if (ContentCatalog::fromDetail(detail, entry)) {
+        std::lock_guard<std::mutex> lock(m_catalogMutex);
+        if (m_catalogStarted) {
+            m_catalog.put(entry);
+        }
+    }
+    return detail;
+}
+
+bool CameraDeviceWrapper::getContentVersion(uint32_t contentHandle, std::string& modified, uint64_t& size) {
+    if (getCatalogedVersion(contentHandle, modified, size)) {
+        return true;
+    }
+    CatalogEntry entry;
+    if (!ContentCatalog::fromDetail(getContentsDetailInfo(contentHandle), entry) || entry.captured.empty()) {
+        return false;
+    }
+    modified = entry.captured;
+    size = entry.size;
+    return true;
+}
+
+bool CameraDeviceWrapper::getCatalogedVersion(uint32_t contentHandle, std::string& modified, uint64_t& size) const {
+    CatalogEntry entry;
+    if (!m_catalog.get(contentHandle, entry) || entry.captured.empty()) {
+        return false;
+    }
+    modified = entry.captured;
+    size = entry.size;
+    return true;
+}
+
+std::string CameraDeviceWrapper::pullContentsFile(uint32_t contentHandle, const std::string& saveDir) {
+    // Only starting the transfer holds the queue; the wait for it happens on
+    // the caller's thread, so thumbnails and property reads are not stuck
+    // behind a large file coming off the card
+    uint64_t pullId = m_queue.run<uint64_t>(CommandPriority::Content, [this, self = shared_from_this(), contentHandle, saveDir]() {
+        return sdkStartPull(contentHandle, saveDir);
+    });
+    if (pullId == 0) {
+        return "";
+    }
+    return awaitPull(pullId, contentHandle, saveDir);
+}
+
+std::vector<uint8_t> CameraDeviceWrapper::getThumbnail(uint32_t contentHandle) {
+    if (auto cached = m_thumbnails.get(contentHandle)) {
+        return *cached;
+    }
+    notePrefetchHint(contentHandle);
+
+    auto data = coalescedRead<std::vector<uint8_t>>(m_thumbnailReads, std::to_string(contentHandle),
+                                                    CommandPriority::Content, [this, contentHandle](bool& ok) {
+        // The prefetcher may have fetched it while this waited in the queue
+        if (auto cached = m_thumbnails.get(contentHandle)) {
+            ok = true;
+            return *cached;
+        }
+        auto fetched = sdkGetThumbnail(contentHandle);
+        ok = !fetched.empty();
+        return fetched;
+    });
+    m_thumbnails.put(contentHandle, data);
+    return data;
+}
+
+std::shared_future<std::vector<uint8_t>> CameraDeviceWrapper::fetchThumbnailAsync(
+    uint32_t contentHandle, std::shared_ptr<std::atomic<bool>> cancelled, std::shared_ptr<void> hold) {
+    if (auto cached = m_thumbnails.get(contentHandle)) {
+        std::promise<std::vector<uint8_t>> ready;
+        ready.set_value(std::move(*cached));
+        return ready.get_future().share();
+    }
+
+    return m_queue.submit<std::vector<uint8_t>>(CommandPriority::Content,
+                                                [this, self = shared_from_this(), contentHandle, cancelled, hold]() mutable {
+        if (cancelled->load()) {
+            return std::vector<uint8_t>();
+        }
+        if (auto cached = m_thumbnails.get(contentHandle)) {
+            return *cached;
+        }
+        auto data = sdkGetThumbnail(contentHandle);
+        hold.reset();
+        m_thumbnails.put(contentHandle, data);
+        return data;
+    });
+}
+
+void CameraDeviceWrapper::startPrefetch(uint32_t folderHandle, const nlohmann::json& handles) {
+    if (!m_thumbnails.isEnabled() || !handles.is_array() || handles.empty()) {
+        return;
+    }
+
+    std::vector<uint32_t> order;
+    for (const auto& handle : handles) {
+        order.push_back(handle.get<uint32_t>());
+    }
+
+    std::lock_guard<std::mutex> lock(m_prefetchMutex);
+    // Listing the same folder again keeps the cursor where it is
+    if (folderHandle == m_prefetchFolder && order == m_prefetchOrder) {
+        return;
+    }
+
+    // A new folder replaces the old one's remaining work
+    m_prefetchFolder = folderHandle;
+    m_prefetchOrder = std::move(order);
+    m_prefetchIndex.clear();
+    m_prefetchPending.clear();
+    for (size_t i = 0; i < m_prefetchOrder.size(); i++) {
+        m_prefetchIndex[m_prefetchOrder[i]] = i;
+        m_prefetchPending.insert(m_prefetchOrder[i]);
+    }
+    m_prefetchCursor = 0;
+
+    if (!m_prefetchScheduled) {
+        schedulePrefetch();
+    }
+}
+
+void CameraDeviceWrapper::notePrefetchHint(uint32_t contentHandle) {
+    std::lock_guard<std::mutex> lock(m_prefetchMutex);
+    auto it = m_prefetchIndex.find(contentHandle);
+    if (it != m_prefetchIndex.end()) {
+        // Clients scroll forward from what they just asked for
+        m_prefetchCursor = it->second + 1;
+    }
+}
+
+void CameraDeviceWrapper::schedulePrefetch() {
+    m_prefetchScheduled = true;
+    m_queue.submit<bool>(CommandPriority::Background, [this, self = shared_from_this()]() {
+        runPrefetch();
+        return true;
+    });
+}
+
+void CameraDeviceWrapper::runPrefetch() {
+    uint32_t handle = 0;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(m_prefetchMutex);
+        size_t count = m_prefetchOrder.size();
+        for (size_t i = 0; i < count && !found; i++) {
+            size_t index = (m_prefetchCursor + i) % count;
+            if (m_prefetchPending.erase(m_prefetchOrder[index]) != 0) {
+                handle = m_prefetchOrder[index];
+                m_prefetchCursor = index + 1;
+                found = true;
+            }
+        }
+        if (!found) {
+            m_prefetchScheduled = false;
+            return;
+        }
+    }
+
+    if (m_connected.load() && !m_thumbnails.contains(handle)) {
+        m_thumbnails.put(handle, sdkGetThumbnail(handle));
+    }
+
+    std::lock_guard<std::mutex> lock(m_prefetchMutex);
+    schedulePrefetch();
+}
+
+std::chrono::milliseconds CameraDeviceWrapper::getIdleTime() const {
+    auto liveView = std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(m_lastLiveView.load()));
+    auto last = std::max(liveView, m_queue.lastInteractive());
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - last);
+}
+
+bool CameraDeviceWrapper::queryCatalog(const CatalogQuery& query, CatalogPage& page) {
+    {
+        std::lock_guard<std::mutex> lock(m_catalogMutex);
+        if (!m_catalogStarted && m_connected.load()) {
+            m_catalogStarted = true;
+            scheduleCatalogScan();
+        }
+    }
+    return m_catalog.query(query, page);
+}
+
+nlohmann::json CameraDeviceWrapper::getCatalogStatus() {
+    std::lock_guard<std::mutex> lock(m_catalogMutex);
+    std::string state = "idle";
+    if (m_catalogStarted) {
+        bool busy = m_catalogScanQueued || m_catalogInFlight > 0 || !m_catalogPending.empty();
+        state = busy ? "building" : "ready";
+    }
+    return {{"state", state}, {"listed", m_catalog.listedCount()}, {"indexed", m_catalog.size()}};
+}
+
+void CameraDeviceWrapper::scheduleCatalogScan() {
+    if (m_catalogScanQueued) {
+        return;
+    }
+    m_catalogScanQueued = true;
+    uint64_t generation = m_catalogGeneration;
+    m_queue.submit<bool>(CommandPriority::Background, [this, self = shared_from_this(), generation]() {
+        runCatalogScan(generation);
+        return true;
+    });
+}
 
+void CameraDeviceWrapper::runCatalogScan(uint64_t generation) {
+    {
+        std::lock_guard<std::mutex> lock(m_catalogMutex);
+        if (generation != m_catalogGeneration) {
+            return;
+        }
+        m_catalogScanAgain = false;
+    }
+
+    std::unordered_map<uint32_t, uint32_t> listing;
+    for (const auto& folder : sdkGetDateFolderList()) {
+        uint32_t folderHandle = folder.value("handle", 0u);
+        for (const auto& handle : sdkGetContentsHandleList(folderHandle)) {
+            listing[handle.get<uint32_t>()] = folderHandle;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_catalogMutex);
+    if (generation != m_catalogGeneration) {
+        return;
+    }
+    m_catalogScanQueued = false;
+    // An empty listing from a dropped session would wipe the catalog
+    if (!m_connected.load()) {
+        return;
+    }
+
+    auto missing = m_catalog.setListing(listing);
+    m_catalogPending.assign(missing.begin(), missing.end());
+    if (m_catalogScanAgain) {
+        scheduleCatalogScan();
+    }
+    scheduleCatalogDetails();
+}
+
+void CameraDeviceWrapper::scheduleCatalogDetails() {
+    uint64_t generation = m_catalogGeneration;
+    while (m_catalogInFlight < kCatalogInFlight && !m_catalogPending.empty()) {
+        uint32_t handle = m_catalogPending.front();
+        m_catalogPending.pop_front();
+        m_catalogInFlight++;
+        m_queue.submit<bool>(CommandPriority::Background, [this, self = shared_from_this(), handle, generation]() {
+            runCatalogDetail(handle, generation);
+            return true;
+        });
+    }
+}
+
+void CameraDeviceWrapper::runCatalogDetail(uint32_t contentHandle, uint64_t generation) {
+    CatalogEntry entry;
+    bool found = m_connected.load() && ContentCatalog::fromDetail(sdkGetContentsDetailInfo(contentHandle), entry);
+
+    std::lock_guard<std::mutex> lock(m_catalogMutex);
+    if (generation != m_catalogGeneration) {
+        return;
+    }
+    m_catalogInFlight--;
+    if (found && m_catalog.isListed(contentHandle)) {
+        m_catalog.put(entry);
+    }
+    scheduleCatalogDetails();
+}
+
+void CameraDeviceWrapper::noteCatalogChange(uint32_t contentHandle) {
+    std::lock_guard<std::mutex> lock(m_catalogMutex);
+    // Transfers of contents already listed are our own downloads
+    if (!m_catalogStarted || m_catalog.isListed(contentHandle)) {
+        return;
+    }
+    if (m_catalogScanQueued) {
+        m_catalogScanAgain = true;
+    } else {
+        scheduleCatalogScan();
+    }
+}
+
+void CameraDeviceWrapper::resetCatalog() {
+    std::lock_guard<std::mutex> lock(m_catalogMutex);
+    m_catalog.clear();
+    m_catalogStarted = false;
+    m_catalogScanQueued = false;
+    m_catalogScanAgain = false;
+    m_catalogPending.clear();
+    m_catalogInFlight = 0;
+    m_catalogGeneration++;
+}
+
+void CameraDeviceWrapper::resetPrefetch() {
+    std::lock_guard<std::mutex> lock(m_prefetchMutex);
+    m_prefetchFolder = 0;
+    m_prefetchOrder.clear();
+    m_prefetchIndex.clear();
+    m_prefetchPending.clear();
+    m_prefetchCursor = 0;
+}
+
+// SDK implementations (command queue thread)
+
+
+bool CameraDeviceWrapper::sdkConnect(int mode, bool reconnect, int timeoutMs) {
     if (m_connected.load()) {
         return true;
     }
@@ -54,7 +622,17 @@ bool CameraDeviceWrapper::connect(int mode, bool reconnect) {
     std::cout << "[Camera " << m_index << "] Connecting in "
               << (mode == 0 ? "Remote" : "ContentsTransfer") << " mode...\n";
 
-    auto err = SDK::Connect(m_info, this, &m_handle, sdkMode, recon);
+    uint64_t eventsBefore;
+    {
+        std::lock_guard<std::mutex> lock(m_connectMutex);
+        eventsBefore = m_connectionEvents;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    SDK::CrDeviceHandle handle = 0;
+    auto err = SdkProfiler::call(SdkFunction::Connect, m_index, mode, reconnect, [&]() {
+        return SDK::Connect(m_info, this, &handle, sdkMode, recon);
+    });
 
     if (err != SDK::CrError_None) {
         std::cerr << "[Camera " << m_index << "] Connect failed: 0x"
@@ -62,48 +640,148 @@ bool CameraDeviceWrapper::connect(int mode, bool reconnect) {
         return false;
     }
 
+    // Came back after the watchdog gave up on it: the session it opened
+    // belongs to no one, and a newer one may already be published
+    if (m_queue.workerAbandoned()) {
+        std::cerr << "[Camera " << m_index << "] Abandoned connect returned; closing its session\n";
+        SdkProfiler::call(SdkFunction::Disconnect, m_index, 0, 0, [&]() { return SDK::Disconnect(handle); });
+        releaseDevice(handle);
+        return false;
+    }
+    publishHandle(handle);
+
     m_mode = mode;
+    m_reconnect = reconnect;
+
+    // Wait for OnConnected (or OnDisconnected on rejection) up to the deadline
+    {
+        std::unique_lock<std::mutex> lock(m_connectMutex);
+        m_connectCv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this, eventsBefore]() {
+            return m_connectionEvents != eventsBefore;
+        });
+    }
 
-    // Wait briefly for OnConnected callback
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    if (m_queue.workerAbandoned()) {
+        return false;  // The new worker owns the session now
+    }
+    if (!m_connected.load()) {
+        std::cerr << "[Camera " << m_index << "] No connection after " << timeoutMs << " ms\n";
+        handle = takeHandle();
+        SdkProfiler::call(SdkFunction::Disconnect, m_index, 0, 0, [&]() { return SDK::Disconnect(handle); });
+        releaseDevice(handle);
+        return false;
+    }
 
-    return m_connected.load();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    std::cout << "[Camera " << m_index << "] Session open after " << elapsed << " ms\n";
+    return true;
 }
 
-bool CameraDeviceWrapper::disconnect() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
-    if (!m_connected.load() || m_handle == 0) {
+bool CameraDeviceWrapper::sdkDisconnect() {
+    SDK::CrDeviceHandle handle = takeHandle();
+    if (handle == 0) {
         return true;
     }
 
-    std::cout << "[Camera " << m_index << "] Disconnecting...\n";
-
-    auto err = SDK::Disconnect(m_handle);
-    if (err != SDK::CrError_None) {
-        std::cerr << "[Camera " << m_index << "] Disconnect failed: 0x"
-                  << std::hex << err << std::dec << "\n";
+    // A dropped session still holds a device handle that must be released
+    if (m_connected.load()) {
+        std::cout << "[Camera " << m_index << "] Disconnecting...\n";
+
+        auto err = SdkProfiler::call(SdkFunction::Disconnect, m_index, 0, 0, [&]() {
+            return SDK::Disconnect(handle);
+        });
+        if (err != SDK::CrError_None) {
+            std::cerr << "[Camera " << m_index << "] Disconnect failed: 0x"
+                      << std::hex << err << std::dec << "\n";
+        }
     }
 
-    SDK::ReleaseDevice(m_handle);
-    m_handle = 0;
-    m_connected.store(false);
+    releaseDevice(handle);
+    if (!m_queue.workerAbandoned()) {
+        m_connected.store(false);
+    }
 
     return true;
 }
 
-nlohmann::json CameraDeviceWrapper::getAllProperties() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    nlohmann::json result = nlohmann::json::array();
+// m_handleMutex is only held to swap the handle or count leases, never
+// across an SDK call: a Connect or Disconnect that hangs (and is abandoned
+// by the watchdog) must not leave it held
+void CameraDeviceWrapper::publishHandle(SDK::CrDeviceHandle handle) {
+    std::lock_guard<std::mutex> lock(m_handleMutex);
+    m_handle.store(handle);
+    m_sessionGeneration++;
+}
+
+SDK::CrDeviceHandle CameraDeviceWrapper::takeHandle() {
+    std::lock_guard<std::mutex> lock(m_handleMutex);
+    m_sessionGeneration++;
+    return m_handle.exchange(0);
+}
+
+void CameraDeviceWrapper::releaseDevice(SDK::CrDeviceHandle handle) {
+    {
+        std::lock_guard<std::mutex> lock(m_handleMutex);
+        if (m_handleLeases.count(handle) != 0) {
+            // A call stuck in the SDK still uses it; its lease releases it
+            m_releasePending.insert(handle);
+            std::cerr << "[Camera " << m_index << "] Device handle still in use; release deferred\n";
+            return;
+        }
+    }
+    SdkProfiler::call(SdkFunction::ReleaseDevice, m_index, 0, 0, [&]() { return SDK::ReleaseDevice(handle); });
+}
+
+CameraDeviceWrapper::SessionLease::SessionLease(CameraDeviceWrapper& owner)
+    : m_owner(owner)
+{
+    std::lock_guard<std::mutex> lock(owner.m_handleMutex);
+    m_handle = owner.m_handle.load();
+    m_generation = owner.m_sessionGeneration.load();
+    if (m_handle != 0) {
+        owner.m_handleLeases[m_handle]++;
+    }
+}
+
+CameraDeviceWrapper::SessionLease::~SessionLease() {
+    if (m_handle == 0) {
+        return;
+    }
+    bool release = false;
+    {
+        std::lock_guard<std::mutex> lock(m_owner.m_handleMutex);
+        auto it = m_owner.m_handleLeases.find(m_handle);
+        if (it != m_owner.m_handleLeases.end() && --it->second == 0) {
+            m_owner.m_handleLeases.erase(it);
+            release = m_owner.m_releasePending.erase(m_handle) != 0;
+        }
+    }
+    if (release) {
+        std::cout << "[Camera " << m_owner.m_index << "] Stuck call returned; releasing its device handle\n";
+        SdkProfiler::call(SdkFunction::ReleaseDevice, m_owner.m_index, 0, 0, [&]() {
+            return SDK::ReleaseDevice(m_handle);
+        });
+    }
+}
+
+bool CameraDeviceWrapper::SessionLease::stale() const {
+    return m_owner.m_sessionGeneration.load() != m_generation || m_owner.m_queue.workerAbandoned();
+}
 
-    if (!m_connected.load() || m_handle == 0) {
+nlohmann::json CameraDeviceWrapper::sdkGetAllProperties(bool* ok) {
+    nlohmann::json result = nlohmann::json::array();
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0) {
         return result;
     }
 
     SDK::CrDeviceProperty* propList = nullptr;
     CrInt32 numProps = 0;
 
-    auto err = SDK::GetDeviceProperties(m_handle, &propList, &numProps);
+    auto err = SdkProfiler::call(SdkFunction::GetDeviceProperties, m_index, 0, 0, [&]() {
+        return SDK::GetDeviceProperties(lease.handle(), &propList, &numProps);
+    });
     if (err != SDK::CrError_None || !propList) {
         return result;
     }
@@ -168,28 +846,32 @@ nlohmann::json CameraDeviceWrapper::getAllProperties() {
         result.push_back(propJson);
     }
 
-    SDK::ReleaseDeviceProperties(m_handle, propList);
+    SDK::ReleaseDeviceProperties(lease.handle(), propList);
+    if (ok && !lease.stale()) {
+        *ok = true;
+    }
     return result;
 }
 
-nlohmann::json CameraDeviceWrapper::getSelectProperties(const std::vector<uint32_t>& codes) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+nlohmann::json CameraDeviceWrapper::sdkGetSelectProperties(const std::vector<uint32_t>& codes, bool* ok) {
     nlohmann::json result = nlohmann::json::array();
-
-    if (!m_connected.load() || m_handle == 0 || codes.empty()) {
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0 || codes.empty()) {
         return result;
     }
 
     SDK::CrDeviceProperty* propList = nullptr;
     CrInt32 numProps = 0;
 
-    auto err = SDK::GetSelectDeviceProperties(
-        m_handle,
-        static_cast<CrInt32u>(codes.size()),
-        const_cast<CrInt32u*>(codes.data()),
-        &propList,
-        &numProps
-    );
+    auto err = SdkProfiler::call(SdkFunction::GetSelectDeviceProperties, m_index, codes.size(), codes[0], [&]() {
+        return SDK::GetSelectDeviceProperties(
+            lease.handle(),
+            static_cast<CrInt32u>(codes.size()),
+            const_cast<CrInt32u*>(codes.data()),
+            &propList,
+            &numProps
+        );
+    });
 
     if (err != SDK::CrError_None || !propList) {
         return result;
@@ -204,14 +886,16 @@ nlohmann::json CameraDeviceWrapper::getSelectProperties(const std::vector<uint32
         result.push_back(propJson);
     }
 
-    SDK::ReleaseDeviceProperties(m_handle, propList);
+    SDK::ReleaseDeviceProperties(lease.handle(), propList);
+    if (ok && !lease.stale()) {
+        *ok = true;
+    }
     return result;
 }
 
-bool CameraDeviceWrapper::setProperty(uint32_t code, uint64_t value) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
-    if (!m_connected.load() || m_handle == 0) {
+bool CameraDeviceWrapper::sdkSetProperty(uint32_t code, uint64_t value) {
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0) {
         return false;
     }
 
@@ -220,24 +904,37 @@ bool CameraDeviceWrapper::setProperty(uint32_t code, uint64_t value) {
     prop.SetCurrentValue(value);
     prop.SetValueType(SDK::CrDataType_UInt32Array);
 
-    auto err = SDK::SetDeviceProperty(m_handle, &prop);
+    auto err = SdkProfiler::call(SdkFunction::SetDeviceProperty, m_index, code, value, [&]() {
+        return SDK::SetDeviceProperty(lease.handle(), &prop);
+    });
     if (err != SDK::CrError_None) {
         std::cerr << "[Camera " << m_index << "] SetDeviceProperty failed: 0x"
                   << std::hex << err << std::dec << "\n";
         return false;
     }
 
+    // Came back after the session was replaced: not this session's setting
+    if (lease.stale()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_appliedMutex);
+        m_appliedProperties[code] = value;
+    }
+    m_reads.invalidatePrefix("properties");
+
     return true;
 }
 
-bool CameraDeviceWrapper::sendCommand(uint32_t commandId, uint32_t param) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
-    if (!m_connected.load() || m_handle == 0) {
+bool CameraDeviceWrapper::sdkSendCommand(uint32_t commandId, uint32_t param) {
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0) {
         return false;
     }
 
-    auto err = SDK::SendCommand(m_handle, commandId, static_cast<SDK::CrCommandParam>(param));
+    auto err = SdkProfiler::call(SdkFunction::SendCommand, m_index, commandId, param, [&]() {
+        return SDK::SendCommand(lease.handle(), commandId, static_cast<SDK::CrCommandParam>(param));
+    });
     if (err != SDK::CrError_None) {
         std::cerr << "[Camera " << m_index << "] SendCommand failed: 0x"
                   << std::hex << err << std::dec << "\n";
@@ -247,44 +944,37 @@ bool CameraDeviceWrapper::sendCommand(uint32_t commandId, uint32_t param) {
     return true;
 }
 
-bool CameraDeviceWrapper::capture() {
-    // Press shutter
-    if (!sendCommand(SDK::CrCommandId_Release, SDK::CrCommandParam_Down)) {
-        return false;
-    }
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(35));
-
-    // Release shutter
-    return sendCommand(SDK::CrCommandId_Release, SDK::CrCommandParam_Up);
-}
-
-bool CameraDeviceWrapper::startRecording() {
-    return sendCommand(SDK::CrCommandId_MovieRecord, SDK::CrCommandParam_Down);
-}
-
-bool CameraDeviceWrapper::stopRecording() {
-    return sendCommand(SDK::CrCommandId_MovieRecord, SDK::CrCommandParam_Up);
-}
-
-bool CameraDeviceWrapper::halfPressShutter() {
-    return sendCommand(SDK::CrCommandId_Release, SDK::CrCommandParam_Down);
-}
-
-bool CameraDeviceWrapper::releaseShutter() {
-    return sendCommand(SDK::CrCommandId_Release, SDK::CrCommandParam_Up);
-}
-
+// Live view frames are polled at stream rate and bypass the command queue.
+// Only one frame is read at a time: a request arriving while one is in the
+// SDK gets no frame rather than waiting for it, so a hung call cannot pile
+// up HTTP workers, and the watchdog reports it (see abandonStalledCall).
 std::vector<uint8_t> CameraDeviceWrapper::getLiveViewImage() {
-    std::lock_guard<std::mutex> lock(m_liveViewMutex);
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    m_lastLiveView.store(now);
+    std::unique_lock<std::mutex> lock(m_liveViewMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return {};
+    }
 
-    if (!m_connected.load() || m_handle == 0) {
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0) {
         return {};
     }
 
+    m_liveViewStarted.store(now);
+    struct Finished {
+        CameraDeviceWrapper& owner;
+        ~Finished() {
+            owner.m_liveViewStarted.store(0);
+            owner.m_liveViewStallReported.store(false);
+        }
+    } finished{*this};
+
     // Get buffer size
     SDK::CrImageInfo info;
-    auto err = SDK::GetLiveViewImageInfo(m_handle, &info);
+    auto err = SdkProfiler::call(SdkFunction::GetLiveViewImageInfo, m_index, 0, 0, [&]() {
+        return SDK::GetLiveViewImageInfo(lease.handle(), &info);
+    });
     if (err != SDK::CrError_None) {
         return {};
     }
@@ -303,7 +993,9 @@ std::vector<uint8_t> CameraDeviceWrapper::getLiveViewImage() {
     imageData.SetSize(bufSize);
     imageData.SetData(m_liveViewBuffer.data());
 
-    err = SDK::GetLiveViewImage(m_handle, &imageData);
+    err = SdkProfiler::call(SdkFunction::GetLiveViewImage, m_index, bufSize, 0, [&]() {
+        return SDK::GetLiveViewImage(lease.handle(), &imageData);
+    });
     if (err != SDK::CrError_None) {
         return {};
     }
@@ -319,35 +1011,64 @@ std::vector<uint8_t> CameraDeviceWrapper::getLiveViewImage() {
     return std::vector<uint8_t>(imgPtr, imgPtr + imgSize);
 }
 
-nlohmann::json CameraDeviceWrapper::getLiveViewInfo() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    nlohmann::json result;
+bool CameraDeviceWrapper::sdkSetS1Lock(bool locked) {
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0) {
+        return false;
+    }
 
-    if (!m_connected.load() || m_handle == 0) {
+    // Not recorded in m_appliedProperties; a half-press must not be replayed
+    SDK::CrDeviceProperty prop;
+    prop.SetCode(SDK::CrDeviceProperty_S1);
+    prop.SetCurrentValue(locked ? SDK::CrLockIndicator_Locked : SDK::CrLockIndicator_Unlocked);
+    prop.SetValueType(SDK::CrDataType_UInt16);
+
+    auto err = SdkProfiler::call(SdkFunction::SetDeviceProperty, m_index, SDK::CrDeviceProperty_S1, locked, [&]() {
+        return SDK::SetDeviceProperty(lease.handle(), &prop);
+    });
+    if (err != SDK::CrError_None) {
+        std::cerr << "[Camera " << m_index << "] S1 lock failed: 0x"
+                  << std::hex << err << std::dec << "\n";
+        return false;
+    }
+    return true;
+}
+
+nlohmann::json CameraDeviceWrapper::sdkGetLiveViewInfo(bool* ok) {
+    nlohmann::json result;
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0) {
         return result;
     }
 
     SDK::CrImageInfo info;
-    auto err = SDK::GetLiveViewImageInfo(m_handle, &info);
-    if (err == SDK::CrError_None) {
-        result["bufferSize"] = info.GetBufferSize();
+    auto err = SdkProfiler::call(SdkFunction::GetLiveViewImageInfo, m_index, 0, 0, [&]() {
+        return SDK::GetLiveViewImageInfo(lease.handle(), &info);
+    });
+    if (err != SDK::CrError_None) {
+        return result;
     }
 
+    result["bufferSize"] = info.GetBufferSize();
+    if (ok && !lease.stale()) {
+        *ok = true;
+    }
     return result;
 }
 
-nlohmann::json CameraDeviceWrapper::getDateFolderList() {
-    std::lock_guard<std::mutex> lock(m_mutex);
+nlohmann::json CameraDeviceWrapper::sdkGetDateFolderList(bool* ok) {
     nlohmann::json result = nlohmann::json::array();
-
-    if (!m_connected.load() || m_handle == 0) {
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0) {
         return result;
     }
 
     SDK::CrMtpFolderInfo* folders = nullptr;
     CrInt32u numFolders = 0;
 
-    auto err = SDK::GetDateFolderList(m_handle, &folders, &numFolders);
+    auto err = SdkProfiler::call(SdkFunction::GetDateFolderList, m_index, 0, 0, [&]() {
+        return SDK::GetDateFolderList(lease.handle(), &folders, &numFolders);
+    });
     if (err != SDK::CrError_None || !folders) {
         return result;
     }
@@ -368,22 +1089,26 @@ nlohmann::json CameraDeviceWrapper::getDateFolderList() {
         result.push_back(folder);
     }
 
-    SDK::ReleaseDateFolderList(m_handle, folders);
+    SDK::ReleaseDateFolderList(lease.handle(), folders);
+    if (ok && !lease.stale()) {
+        *ok = true;
+    }
     return result;
 }
 
-nlohmann::json CameraDeviceWrapper::getContentsHandleList(uint32_t folderHandle) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+nlohmann::json CameraDeviceWrapper::sdkGetContentsHandleList(uint32_t folderHandle, bool* ok) {
     nlohmann::json result = nlohmann::json::array();
-
-    if (!m_connected.load() || m_handle == 0) {
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0) {
         return result;
     }
 
     SDK::CrContentHandle* handles = nullptr;
     CrInt32u numContents = 0;
 
-    auto err = SDK::GetContentsHandleList(m_handle, folderHandle, &handles, &numContents);
+    auto err = SdkProfiler::call(SdkFunction::GetContentsHandleList, m_index, folderHandle, 0, [&]() {
+        return SDK::GetContentsHandleList(lease.handle(), folderHandle, &handles, &numContents);
+    });
     if (err != SDK::CrError_None || !handles) {
         return result;
     }
@@ -392,64 +1117,142 @@ nlohmann::json CameraDeviceWrapper::getContentsHandleList(uint32_t folderHandle)
         result.push_back(handles[i]);
     }
 
-    SDK::ReleaseContentsHandleList(m_handle, handles);
+    SDK::ReleaseContentsHandleList(lease.handle(), handles);
+    if (ok && !lease.stale()) {
+        *ok = true;
+    }
     return result;
 }
 
-nlohmann::json CameraDeviceWrapper::getContentsDetailInfo(uint32_t contentHandle) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+nlohmann::json CameraDeviceWrapper::sdkGetContentsDetailInfo(uint32_t contentHandle, bool* ok) {
     nlohmann::json result;
-
-    if (!m_connected.load() || m_handle == 0) {
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0) {
         return result;
     }
 
     SDK::CrMtpContentsInfo info;
-    auto err = SDK::GetContentsDetailInfo(m_handle, contentHandle, &info);
+    auto err = SdkProfiler::call(SdkFunction::GetContentsDetailInfo, m_index, contentHandle, 0, [&]() {
+        return SDK::GetContentsDetailInfo(lease.handle(), contentHandle, &info);
+    });
     if (err != SDK::CrError_None) {
         return result;
     }
 
     result["handle"] = contentHandle;
-    // Add more fields based on CrMtpContentsInfo structure
+    result["folderHandle"] = info.parentFolderHandle;
+    result["size"] = info.contentSize;
+    if (info.fileName && info.fileNameSize > 0) {
+        std::string name;
+        const CrChar* p = info.fileName;
+        while (*p) {
+            name += static_cast<char>(*p);
+            p++;
+        }
+        result["fileName"] = name;
+    }
+    std::string modified;
+    const size_t maxLength = sizeof(info.modificationDatetimeUTC) / sizeof(CrChar);
+    for (size_t i = 0; i < maxLength && info.modificationDatetimeUTC[i]; i++) {
+        modified += static_cast<char>(info.modificationDatetimeUTC[i]);
+    }
+    result["modified"] = modified;
 
+    if (ok && !lease.stale()) {
+        *ok = true;
+    }
     return result;
 }
 
-bool CameraDeviceWrapper::pullContentsFile(uint32_t contentHandle, const std::string& savePath) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
-    if (!m_connected.load() || m_handle == 0) {
-        return false;
+uint64_t CameraDeviceWrapper::sdkStartPull(uint32_t contentHandle, const std::string& saveDir) {
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0) {
+        return 0;
     }
 
     // Convert path to SDK format
-    std::vector<CrChar> pathBuf(savePath.begin(), savePath.end());
+    std::vector<CrChar> pathBuf(saveDir.begin(), saveDir.end());
     pathBuf.push_back(0);
 
-    auto err = SDK::PullContentsFile(m_handle, contentHandle,
+    // Registered first so a fast completion is not missed
+    uint64_t pullId;
+    {
+        std::lock_guard<std::mutex> lock(m_pullMutex);
+        pullId = m_nextPullId++;
+        m_pulls[pullId].contentHandle = contentHandle;
+    }
+
+    auto err = SdkProfiler::call(SdkFunction::PullContentsFile, m_index, contentHandle, 0, [&]() {
+        return SDK::PullContentsFile(lease.handle(), contentHandle,
                                      SDK::CrPropertyStillImageTransSize_Original,
                                      pathBuf.data(), nullptr);
+    });
 
-    return err == SDK::CrError_None;
+    if (err != SDK::CrError_None || lease.stale()) {
+        std::lock_guard<std::mutex> lock(m_pullMutex);
+        m_pulls.erase(pullId);
+        if (err == SDK::CrError_None) {
+            return 0;  // Started in a session that is gone
+        }
+        std::cerr << "[Camera " << m_index << "] PullContentsFile failed: 0x"
+                  << std::hex << err << std::dec << "\n";
+        return 0;
+    }
+    return pullId;
 }
 
-std::vector<uint8_t> CameraDeviceWrapper::getThumbnail(uint32_t contentHandle) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+std::string CameraDeviceWrapper::awaitPull(uint64_t pullId, uint32_t contentHandle, const std::string& saveDir) {
+    std::unique_lock<std::mutex> lock(m_pullMutex);
+
+    // The call only starts the transfer; OnNotifyContentsTransfer ends it
+    m_pullCv.wait_for(lock, std::chrono::milliseconds(kPullWaitMs), [this, pullId]() {
+        auto it = m_pulls.find(pullId);
+        return it == m_pulls.end() || it->second.done || !m_connected.load();
+    });
+    PullResult result;
+    auto it = m_pulls.find(pullId);
+    if (it != m_pulls.end()) {
+        result = it->second;
+        m_pulls.erase(it);
+    }
+    lock.unlock();
+
+    if (!result.ok) {
+        std::cerr << "[Camera " << m_index << "] Transfer of content " << contentHandle
+                  << (result.done ? " failed" : " did not complete") << "\n";
+        return "";
+    }
 
-    if (!m_connected.load() || m_handle == 0) {
+    // Reported as a bare file name or a full path depending on the platform;
+    // without a name the caller has to look in saveDir
+    if (result.filename.empty()) {
+        return saveDir;
+    }
+    if (result.filename[0] != '/') {
+        return saveDir + "/" + result.filename;
+    }
+    return result.filename;
+}
+
+std::vector<uint8_t> CameraDeviceWrapper::sdkGetThumbnail(uint32_t contentHandle) {
+    SessionLease lease(*this);
+    if (!m_connected.load() || lease.handle() == 0) {
         return {};
     }
 
-    std::vector<uint8_t> buffer(64 * 1024);  // 64KB buffer
+    // Reused per thread; only the image itself is copied out
+    static thread_local std::vector<uint8_t> buffer(64 * 1024);
     SDK::CrImageDataBlock imageData;
     imageData.SetSize(static_cast<CrInt32u>(buffer.size()));
     imageData.SetData(buffer.data());
 
     SDK::CrFileType fileType;
-    auto err = SDK::GetContentsThumbnailImage(m_handle, contentHandle, &imageData, &fileType);
+    auto err = SdkProfiler::call(SdkFunction::GetContentsThumbnailImage, m_index, contentHandle, 0, [&]() {
+        return SDK::GetContentsThumbnailImage(lease.handle(), contentHandle, &imageData, &fileType);
+    });
 
-    if (err != SDK::CrError_None) {
+    // A late image from an earlier session must not reach the cache
+    if (err != SDK::CrError_None || lease.stale()) {
         return {};
     }
 
@@ -465,35 +1268,75 @@ std::vector<uint8_t> CameraDeviceWrapper::getThumbnail(uint32_t contentHandle) {
 
 // IDeviceCallback implementations
 void CameraDeviceWrapper::OnConnected(SDK::DeviceConnectionVersioin version) {
-    m_connected.store(true);
+    // Nothing read in an earlier session is valid for this one
+    m_reads.clear();
+    m_thumbnailReads.clear();
+    m_thumbnails.clear();
+    resetPrefetch();
+    resetCatalog();
+    {
+        std::lock_guard<std::mutex> lock(m_connectMutex);
+        m_connected.store(true);
+        m_connectionEvents++;
+    }
+    m_connectCv.notify_all();
     std::cout << "[Camera " << m_index << "] Connected (version: " << version << ")\n";
     emitEvent("connected", {{"version", static_cast<int>(version)}});
 }
 
 void CameraDeviceWrapper::OnDisconnected(CrInt32u error) {
-    m_connected.store(false);
+    m_reads.clear();
+    m_thumbnailReads.clear();
+    m_thumbnails.clear();
+    resetPrefetch();
+    resetCatalog();
+    {
+        std::lock_guard<std::mutex> lock(m_connectMutex);
+        m_connected.store(false);
+        m_connectionEvents++;
+    }
+    m_connectCv.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(m_pullMutex);
+    }
+    m_pullCv.notify_all();
     std::cout << "[Camera " << m_index << "] Disconnected (error: 0x"
               << std::hex << error << std::dec << ")\n";
     emitEvent("disconnected", {{"error", error}});
 }
 
 void CameraDeviceWrapper::OnPropertyChanged() {
+    // Drop shared reads before waking anyone waiting for the confirmation
+    m_reads.invalidatePrefix("properties");
+    {
+        std::lock_guard<std::mutex> lock(m_propertyChangeMutex);
+        m_propertyChangeAll++;
+    }
+    m_propertyChangeCv.notify_all();
     emitEvent("property_changed");
 }
 
 void CameraDeviceWrapper::OnPropertyChangedCodes(CrInt32u num, CrInt32u* codes) {
+    m_reads.invalidatePrefix("properties");
     nlohmann::json codesArray = nlohmann::json::array();
-    for (CrInt32u i = 0; i < num; i++) {
-        codesArray.push_back(codes[i]);
+    {
+        std::lock_guard<std::mutex> lock(m_propertyChangeMutex);
+        for (CrInt32u i = 0; i < num; i++) {
+            codesArray.push_back(codes[i]);
+            m_propertyChangeSeq[codes[i]]++;
+        }
     }
+    m_propertyChangeCv.notify_all();
     emitEvent("property_changed", {{"codes", codesArray}});
 }
 
 void CameraDeviceWrapper::OnLvPropertyChanged() {
+    m_reads.invalidate("liveview_info");
     emitEvent("lv_property_changed");
 }
 
 void CameraDeviceWrapper::OnLvPropertyChangedCodes(CrInt32u num, CrInt32u* codes) {
+    m_reads.invalidate("liveview_info");
     nlohmann::json codesArray = nlohmann::json::array();
     for (CrInt32u i = 0; i < num; i++) {
         codesArray.push_back(codes[i]);
@@ -523,7 +1366,32 @@ void CameraDeviceWrapper::OnNotifyContentsTransfer(CrInt32u notify, SDK::CrConte
             p++;
         }
     }
-    emitEvent("content_transfer", {{"notify", notify}, {"handle", handle}, {"filename", filenameStr}});
+    // Card contents changed; folder and contents lists must be re-read
+    m_reads.invalidate("folders");
+    m_reads.invalidatePrefix("contents:");
+    noteCatalogChange(static_cast<uint32_t>(handle));
+
+    // Finishes the earliest unfinished pull of this content; the same file
+    // may be pulled by several requests at once. Events of our own pulls
+    // are marked so they are not taken for new contents.
+    bool pulled = false;
+    {
+        std::lock_guard<std::mutex> lock(m_pullMutex);
+        for (auto& [pullId, pull] : m_pulls) {
+            if (pull.contentHandle == static_cast<uint32_t>(handle) && !pull.done) {
+                pulled = true;
+                if (notify != SDK::CrNotify_ContentsTransfer_Start) {
+                    pull.done = true;
+                    pull.ok = notify == SDK::CrNotify_ContentsTransfer_Complete;
+                    pull.filename = filenameStr;
+                    m_pullCv.notify_all();
+                }
+                break;
+            }
+        }
+    }
+    emitEvent("content_transfer",
+              {{"notify", notify}, {"handle", handle}, {"filename", filenameStr}, {"pulled", pulled}});
 }
 
 void CameraDeviceWrapper::OnWarning(CrInt32u warning) {
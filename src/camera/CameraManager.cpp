@@ -1,18 +1,101 @@
 #include "camera/CameraManager.h"
 #include "CameraRemote_SDK.h"
+#include "util/SdkProfiler.h"
 #include <iostream>
 #include <cstring>
+#include <future>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <unistd.h>
 
 namespace crsdk_rest {
 
 namespace SDK = SCRSDK;
 
+namespace {
+
+std::string toString(const CrChar* str) {
+    std::string result;
+    if (str) {
+        const CrChar* p = str;
+        while (*p) {
+            result += static_cast<char>(*p);
+            p++;
+        }
+    }
+    return result;
+}
+
+CameraEvent makeDiscoveryEvent(const std::string& type, const CameraInfo& info) {
+    CameraEvent event(type, info.index);
+    event.data = {
+        {"identity", info.identity},
+        {"model", info.model},
+        {"connectionType", info.connectionType}
+    };
+    return event;
+}
+
+int openUeventSocket() {
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_pid = 0;
+    addr.nl_groups = 1;  // Kernel uevent multicast group
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Wait up to timeoutMs for a USB uevent; sleeps instead when fd is invalid
+bool waitForUsbEvent(int fd, int timeoutMs) {
+    if (fd < 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+        return false;
+    }
+
+    pollfd pfd{fd, POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMs) <= 0) {
+        return false;
+    }
+
+    char buf[4096];
+    ssize_t len = recv(fd, buf, sizeof(buf) - 1, MSG_DONTWAIT);
+    if (len <= 0) {
+        return false;
+    }
+    buf[len] = 0;
+
+    // Payload is "ACTION@DEVPATH" followed by NUL-separated KEY=VALUE pairs
+    for (ssize_t i = 0; i < len; i += std::strlen(buf + i) + 1) {
+        if (std::strcmp(buf + i, "SUBSYSTEM=usb") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
 CameraManager& CameraManager::getInstance() {
     static CameraManager instance;
     return instance;
 }
 
 CameraManager::~CameraManager() {
+    m_sequencer.stop();
+    stopDiscovery();
+    m_supervisor.stop();
     if (m_initialized.load()) {
         shutdown();
     }
@@ -35,19 +118,21 @@ bool CameraManager::initialize(uint32_t logType) {
 }
 
 void CameraManager::shutdown() {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    // Wait out any enumeration still inside the SDK before releasing it
+    std::lock_guard<std::mutex> scanLock(m_scanMutex);
     if (!m_initialized.load()) {
         return;
     }
 
     // Disconnect all cameras first
-    for (auto& pair : m_cameras) {
-        if (pair.second && pair.second->isConnected()) {
-            pair.second->disconnect();
-        }
+    disconnectAll();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_initialized.load()) {
+        return;
     }
-    m_cameras.clear();
-    m_cameraInfoList.clear();
+    m_discovered.clear();
+    m_scanned.store(false);
 
     SDK::Release();
     m_initialized.store(false);
@@ -55,159 +140,386 @@ void CameraManager::shutdown() {
 }
 
 std::vector<CameraInfo> CameraManager::enumerateCameras(uint8_t timeoutSec) {
+    if (!m_initialized.load()) {
+        std::cerr << "[CameraManager] SDK not initialized\n";
+        return {};
+    }
+
+    scanCameras(timeoutSec);
+    return getCameraList();
+}
+
+std::vector<CameraInfo> CameraManager::getCameraList() {
     std::lock_guard<std::mutex> lock(m_mutex);
+
     std::vector<CameraInfo> result;
+    for (const auto& entry : m_discovered) {
+        if (entry.present) {
+            result.push_back(entry.info);
+        }
+    }
+    return result;
+}
+
+std::string CameraManager::getCameraIdentity(int cameraIndex) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (cameraIndex < 0 || cameraIndex >= static_cast<int>(m_discovered.size())) {
+        return "";
+    }
+    return m_discovered[cameraIndex].info.identity;
+}
+
+void CameraManager::scanCameras(uint8_t timeoutSec) {
+    // One enumeration at a time; the slow SDK call runs without m_mutex so
+    // lookups, connects and events are not held up by it
+    std::lock_guard<std::mutex> scanLock(m_scanMutex);
 
     if (!m_initialized.load()) {
-        std::cerr << "[CameraManager] SDK not initialized\n";
-        return result;
+        return;
     }
 
     SDK::ICrEnumCameraObjectInfo* enumInfo = nullptr;
-    auto err = SDK::EnumCameraObjects(&enumInfo, timeoutSec);
-
-    if (err != SDK::CrError_None || !enumInfo) {
+    auto err = SdkProfiler::call(SdkFunction::EnumCameraObjects, -1, timeoutSec, 0, [&]() {
+        return SDK::EnumCameraObjects(&enumInfo, timeoutSec);
+    });
+
+    // The enumeration owns the object infos; keep it alive while any cache
+    // entry or camera wrapper still points into it
+    std::shared_ptr<SDK::ICrEnumCameraObjectInfo> owner;
+    CrInt32u count = 0;
+    if (err == SDK::CrError_None && enumInfo) {
+        owner.reset(enumInfo, [](SDK::ICrEnumCameraObjectInfo* e) { e->Release(); });
+        count = enumInfo->GetCount();
+    } else {
         std::cerr << "[CameraManager] EnumCameraObjects failed: 0x" << std::hex << err << std::dec << "\n";
-        return result;
     }
 
-    CrInt32u count = enumInfo->GetCount();
-    std::cout << "[CameraManager] Found " << count << " camera(s)\n";
-
-    m_cameraInfoList.clear();
+    struct Found {
+        std::string identity;
+        SDK::ICrCameraObjectInfo* objectInfo;
+        CameraInfo info;
+    };
+    std::vector<Found> found;
+    std::unordered_map<std::string, int> modelOrdinals;
 
     for (CrInt32u i = 0; i < count; i++) {
         auto* info = enumInfo->GetCameraObjectInfo(i);
         if (!info) continue;
 
-        m_cameraInfoList.push_back(const_cast<void*>(static_cast<const void*>(info)));
+        Found cam;
+        cam.objectInfo = const_cast<SDK::ICrCameraObjectInfo*>(info);
+        cam.info.model = toString(info->GetModel());
+        cam.info.connectionType = toString(info->GetConnectionTypeName());
+        cam.info.sshSupported = (info->GetSSHsupport() != 0);
+
+        // Identity from the device id (USB serial / MAC); fall back to the
+        // model and its position among cameras of the same model
+        std::string id;
+        const CrInt8u* idBytes = info->GetId();
+        CrInt32u idSize = info->GetIdSize();
+        static const char* hex = "0123456789abcdef";
+        for (CrInt32u b = 0; idBytes && b < idSize; b++) {
+            id += hex[(idBytes[b] >> 4) & 0xF];
+            id += hex[idBytes[b] & 0xF];
+        }
+        if (id.empty()) {
+            id = cam.info.connectionType + "-" + std::to_string(modelOrdinals[cam.info.model]++);
+        }
+        cam.identity = cam.info.model + ":" + id;
+        cam.info.identity = cam.identity;
+
+        found.push_back(cam);
+    }
 
-        CameraInfo camInfo;
-        camInfo.index = static_cast<int>(i);
+    std::vector<CameraEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
 
-        // Get model name
-        auto model = info->GetModel();
-        if (model) {
-            // Convert from SDK char type to std::string
-            std::string modelStr;
-            const CrChar* p = model;
-            while (*p) {
-                modelStr += static_cast<char>(*p);
-                p++;
+        std::unordered_set<std::string> seen;
+        for (const auto& cam : found) {
+            seen.insert(cam.identity);
+
+            auto it = std::find_if(m_discovered.begin(), m_discovered.end(),
+                [&cam](const DiscoveredCamera& entry) { return entry.info.identity == cam.identity; });
+
+            if (it == m_discovered.end()) {
+                // New device: append so existing indices never shift
+                DiscoveredCamera entry;
+                entry.info = cam.info;
+                entry.info.index = static_cast<int>(m_discovered.size());
+                entry.info.id = "camera-" + std::to_string(entry.info.index);
+                entry.objectInfo = cam.objectInfo;
+                entry.owner = owner;
+                entry.present = true;
+                m_discovered.push_back(entry);
+
+                events.push_back(makeDiscoveryEvent("camera_added", m_discovered.back().info));
+                std::cout << "[CameraManager] Camera " << entry.info.index << ": " << entry.info.model
+                          << " (" << entry.info.connectionType << ")\n";
+                continue;
             }
-            camInfo.model = modelStr;
-        }
 
-        // Generate ID from index
-        camInfo.id = "camera-" + std::to_string(i);
+            // Known device: refresh its object info unless a connect is
+            // using the current one right now
+            if (m_connecting.count(it->info.index) == 0) {
+                it->objectInfo = cam.objectInfo;
+                it->owner = owner;
+                it->info.connectionType = cam.info.connectionType;
+                it->info.sshSupported = cam.info.sshSupported;
+            }
+            if (!it->present) {
+                it->present = true;
+                events.push_back(makeDiscoveryEvent("camera_added", it->info));
+            }
+        }
 
-        // Get connection type
-        auto connType = info->GetConnectionTypeName();
-        if (connType) {
-            std::string connStr;
-            const CrChar* p = connType;
-            while (*p) {
-                connStr += static_cast<char>(*p);
-                p++;
+        for (auto& entry : m_discovered) {
+            if (entry.present && seen.count(entry.info.identity) == 0) {
+                entry.present = false;
+                events.push_back(makeDiscoveryEvent("camera_removed", entry.info));
+                std::cout << "[CameraManager] Camera " << entry.info.index << " removed\n";
             }
-            camInfo.connectionType = connStr;
         }
 
-        camInfo.sshSupported = (info->GetSSHsupport() != 0);
+        m_scanned.store(true);
+    }
 
-        result.push_back(camInfo);
-        std::cout << "[CameraManager] Camera " << i << ": " << camInfo.model
-                  << " (" << camInfo.connectionType << ")\n";
+    for (const auto& event : events) {
+        dispatchEvent(event);
     }
+}
 
-    return result;
+void CameraManager::startDiscovery(int intervalSec) {
+    if (intervalSec <= 0 || m_discoveryRunning.exchange(true)) {
+        return;
+    }
+    m_discoveryThread = std::thread(&CameraManager::discoveryLoop, this, intervalSec);
+    std::cout << "[CameraManager] Background discovery every " << intervalSec << "s\n";
 }
 
-std::shared_ptr<CameraDeviceWrapper> CameraManager::connectCamera(
-    int cameraIndex, int mode, bool reconnect) {
+void CameraManager::stopDiscovery() {
+    m_discoveryRunning.store(false);
+    if (m_discoveryThread.joinable()) {
+        m_discoveryThread.join();
+    }
+}
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+void CameraManager::discoveryLoop(int intervalSec) {
+    // USB hotplug triggers an early rescan; without the socket (e.g. in a
+    // container) the periodic rescan still runs
+    int ueventFd = openUeventSocket();
+    auto nextScan = std::chrono::steady_clock::now();
 
-    if (!m_initialized.load()) {
-        std::cerr << "[CameraManager] SDK not initialized\n";
-        return nullptr;
-    }
+    while (m_discoveryRunning.load()) {
+        if (std::chrono::steady_clock::now() >= nextScan) {
+            scanCameras(kDiscoveryScanTimeoutSec);
+            nextScan = std::chrono::steady_clock::now() + std::chrono::seconds(intervalSec);
+        }
 
-    // Check if already connected
-    auto it = m_cameras.find(cameraIndex);
-    if (it != m_cameras.end() && it->second && it->second->isConnected()) {
-        std::cout << "[CameraManager] Camera " << cameraIndex << " already connected\n";
-        return it->second;
+        if (waitForUsbEvent(ueventFd, 250)) {
+            // One plug produces a burst of uevents; let the device settle
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            while (waitForUsbEvent(ueventFd, 0)) {}
+            nextScan = std::chrono::steady_clock::now();
+        }
     }
 
-    // Get camera info
-    if (cameraIndex < 0 || cameraIndex >= static_cast<int>(m_cameraInfoList.size())) {
-        std::cerr << "[CameraManager] Invalid camera index: " << cameraIndex << "\n";
-        return nullptr;
+    if (ueventFd >= 0) {
+        close(ueventFd);
     }
+}
 
-    auto* info = static_cast<SDK::ICrCameraObjectInfo*>(m_cameraInfoList[cameraIndex]);
-    if (!info) {
-        std::cerr << "[CameraManager] Camera info not found for index: " << cameraIndex << "\n";
-        return nullptr;
+std::shared_ptr<CameraDeviceWrapper> CameraManager::connectCamera(
+    int cameraIndex, int mode, bool reconnect, int timeoutMs) {
+
+    SDK::ICrCameraObjectInfo* info = nullptr;
+    std::shared_ptr<void> infoOwner;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_initialized.load()) {
+            std::cerr << "[CameraManager] SDK not initialized\n";
+            return nullptr;
+        }
+
+        // Check if already connected
+        auto it = m_cameras.find(cameraIndex);
+        if (it != m_cameras.end() && it->second && it->second->isConnected()) {
+            std::cout << "[CameraManager] Camera " << cameraIndex << " already connected\n";
+            return it->second;
+        }
+
+        // Get camera info
+        if (cameraIndex < 0 || cameraIndex >= static_cast<int>(m_discovered.size())) {
+            std::cerr << "[CameraManager] Invalid camera index: " << cameraIndex << "\n";
+            return nullptr;
+        }
+
+        const auto& entry = m_discovered[cameraIndex];
+        if (!entry.present || !entry.objectInfo) {
+            std::cerr << "[CameraManager] Camera " << cameraIndex << " is not present\n";
+            return nullptr;
+        }
+        info = entry.objectInfo;
+        infoOwner = entry.owner;
+
+        if (!m_connecting.insert(cameraIndex).second) {
+            std::cerr << "[CameraManager] Camera " << cameraIndex << " connection already in progress\n";
+            return nullptr;
+        }
     }
 
-    // Create wrapper
+    // Connect without holding m_mutex so other cameras can connect (and be
+    // looked up) while this one waits for its session
     auto wrapper = std::make_shared<CameraDeviceWrapper>(
-        cameraIndex, info,
+        cameraIndex, info, infoOwner,
         [this](const CameraEvent& event) {
             dispatchEvent(event);
         }
     );
+    wrapper->setReadCacheTtl(m_readCacheTtlMs.load());
+    wrapper->setThumbnailCacheBudget(m_thumbnailCacheBytes.load());
+
+    bool connected = wrapper->connect(mode, reconnect, timeoutMs);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_connecting.erase(cameraIndex);
 
-    // Connect
-    if (!wrapper->connect(mode, reconnect)) {
+    if (!connected) {
         std::cerr << "[CameraManager] Failed to connect to camera " << cameraIndex << "\n";
         return nullptr;
     }
 
     m_cameras[cameraIndex] = wrapper;
+    publishSnapshot();
+    m_supervisor.watch(cameraIndex);
     return wrapper;
 }
 
+std::vector<ConnectResult> CameraManager::connectAll(int mode, bool reconnect, int timeoutMs) {
+    std::vector<int> indices;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& entry : m_discovered) {
+            if (entry.present) {
+                indices.push_back(entry.info.index);
+            }
+        }
+    }
+
+    // One connect per enumerated camera, all in flight at once
+    std::vector<std::future<ConnectResult>> pending;
+    for (int index : indices) {
+        pending.push_back(std::async(std::launch::async, [this, index, mode, reconnect, timeoutMs]() {
+            ConnectResult result;
+            result.index = index;
+
+            auto started = std::chrono::steady_clock::now();
+            auto camera = connectCamera(index, mode, reconnect, timeoutMs);
+            result.elapsedMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - started).count();
+
+            result.connected = camera && camera->isConnected();
+            if (camera) {
+                result.model = camera->getModel();
+            }
+            return result;
+        }));
+    }
+
+    std::vector<ConnectResult> results;
+    for (auto& future : pending) {
+        results.push_back(future.get());
+    }
+    return results;
+}
+
 void CameraManager::disconnectCamera(int cameraIndex) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    CameraMap detached;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Stop supervising first so the resulting OnDisconnected is not
+        // mistaken for a dropped link
+        m_supervisor.unwatch(cameraIndex);
 
-    auto it = m_cameras.find(cameraIndex);
-    if (it != m_cameras.end()) {
-        if (it->second && it->second->isConnected()) {
-            it->second->disconnect();
+        auto it = m_cameras.find(cameraIndex);
+        if (it == m_cameras.end()) {
+            return;
         }
+        detached.insert(*it);
         m_cameras.erase(it);
+        publishSnapshot();
     }
+    disconnectDetached(detached);
 }
 
 void CameraManager::disconnectAll() {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    CameraMap detached;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& pair : m_cameras) {
+            m_supervisor.unwatch(pair.first);
+        }
+        detached.swap(m_cameras);
+        publishSnapshot();
+    }
+    disconnectDetached(detached);
+}
 
-    for (auto& pair : m_cameras) {
-        if (pair.second && pair.second->isConnected()) {
-            pair.second->disconnect();
+void CameraManager::disconnectDetached(const CameraMap& cameras) {
+    // Runs without m_mutex: a disconnect can take seconds, and its
+    // OnDisconnected callback looks the camera up. The indices count as
+    // connecting meanwhile so a new session cannot open under the old one.
+    std::vector<int> held;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& pair : cameras) {
+            if (m_connecting.insert(pair.first).second) {
+                held.push_back(pair.first);
+            }
         }
     }
-    m_cameras.clear();
+
+    std::vector<std::future<void>> pending;
+    for (const auto& pair : cameras) {
+        auto camera = pair.second;
+        if (camera && camera->isConnected()) {
+            pending.push_back(std::async(std::launch::async, [camera]() { camera->disconnect(); }));
+        }
+    }
+    for (auto& future : pending) {
+        future.get();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int index : held) {
+        m_connecting.erase(index);
+    }
 }
 
 std::shared_ptr<CameraDeviceWrapper> CameraManager::getConnectedCamera(int cameraIndex) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    // Lock-free read of the published registry; never waits on m_mutex
+    auto snapshot = std::atomic_load(&m_snapshot);
+    if (!snapshot) {
+        return nullptr;
+    }
 
-    auto it = m_cameras.find(cameraIndex);
-    if (it != m_cameras.end() && it->second && it->second->isConnected()) {
+    auto it = snapshot->find(cameraIndex);
+    if (it != snapshot->end() && it->second && it->second->isConnected()) {
         return it->second;
     }
     return nullptr;
 }
 
 std::vector<int> CameraManager::getConnectedCameraIndices() {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    auto snapshot = std::atomic_load(&m_snapshot);
 
     std::vector<int> result;
-    for (const auto& pair : m_cameras) {
+    if (!snapshot) {
+        return result;
+    }
+    for (const auto& pair : *snapshot) {
         if (pair.second && pair.second->isConnected()) {
             result.push_back(pair.first);
         }
@@ -215,6 +527,65 @@ std::vector<int> CameraManager::getConnectedCameraIndices() {
     return result;
 }
 
+bool CameraManager::recoverCamera(int cameraIndex) {
+    std::shared_ptr<CameraDeviceWrapper> camera;
+    SDK::ICrCameraObjectInfo* info = nullptr;
+    std::shared_ptr<void> infoOwner;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_cameras.find(cameraIndex);
+        if (it == m_cameras.end() || !it->second) {
+            return false;
+        }
+        camera = it->second;
+
+        // Prefer the latest object info; a replugged USB camera gets a new one
+        if (cameraIndex < static_cast<int>(m_discovered.size()) && m_discovered[cameraIndex].present) {
+            info = m_discovered[cameraIndex].objectInfo;
+            infoOwner = m_discovered[cameraIndex].owner;
+        }
+
+        if (!m_connecting.insert(cameraIndex).second) {
+            return false;
+        }
+    }
+
+    bool restored = camera->restoreSession(info, infoOwner);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_connecting.erase(cameraIndex);
+    return restored;
+}
+
+std::vector<int> CameraManager::abandonStalledCalls() {
+    std::vector<int> stalled;
+    auto snapshot = std::atomic_load(&m_snapshot);
+    if (!snapshot) {
+        return stalled;
+    }
+
+    for (const auto& pair : *snapshot) {
+        if (pair.second && pair.second->abandonStalledCall()) {
+            stalled.push_back(pair.first);
+        }
+    }
+    return stalled;
+}
+
+nlohmann::json CameraManager::getSessionHealth(int cameraIndex) const {
+    return m_supervisor.getHealth(cameraIndex);
+}
+
+std::string CameraManager::getSessionState(int cameraIndex) const {
+    return m_supervisor.getStateName(cameraIndex);
+}
+
+void CameraManager::publishSnapshot() {
+    // Caller holds m_mutex. Readers holding the previous map keep it alive.
+    std::atomic_store(&m_snapshot, std::make_shared<const CameraMap>(m_cameras));
+}
+
 uint32_t CameraManager::getSDKVersion() {
     return SDK::GetSDKVersion();
 }
@@ -229,6 +600,29 @@ void CameraManager::setEventHandler(std::function<void(const CameraEvent&)> hand
 }
 
 void CameraManager::dispatchEvent(const CameraEvent& event) {
+    if (event.type == "capture_complete") {
+        m_captureJobs.onDownloadComplete(event.cameraIndex, event.data.value("filename", ""));
+        m_offload.onCapturedFile(event.cameraIndex, getCameraIdentity(event.cameraIndex),
+                                 event.data.value("filename", ""));
+    } else if (event.type == "content_transfer") {
+        // New contents, and transfers of ones not offloaded yet; our own
+        // pulls (downloads, archives, the offload itself) are neither
+        if (event.data.value("notify", 0u) != SDK::CrNotify_ContentsTransfer_Start &&
+            !event.data.value("pulled", false)) {
+            m_offload.onNewContent(event.cameraIndex, getCameraIdentity(event.cameraIndex),
+                                   event.data.value("handle", 0u));
+        }
+    } else if (event.type == "connected") {
+        m_supervisor.onConnected(event.cameraIndex);
+    } else if (event.type == "disconnected") {
+        m_supervisor.onDisconnected(event.cameraIndex, event.data.value("error", 0u));
+        // Handles are only meaningful within a session
+        std::string identity = getCameraIdentity(event.cameraIndex);
+        m_spool.invalidate(identity);
+        m_contentCache.forgetSession(identity);
+        m_offload.onDisconnected(event.cameraIndex);
+    }
+
     std::function<void(const CameraEvent&)> handler;
     {
         std::lock_guard<std::mutex> lock(m_mutex);
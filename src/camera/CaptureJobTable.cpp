@@ -0,0 +1,176 @@
+#include "camera/CaptureJobTable.h"
+
+namespace crsdk_rest {
+
+uint64_t CaptureJobTable::create(int cameraIndex) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    CaptureJob job;
+    job.id = m_nextId++;
+    job.cameraIndex = cameraIndex;
+    job.createdAt = std::chrono::system_clock::now();
+    job.created = std::chrono::steady_clock::now();
+    m_jobs[job.id] = job;
+
+    prune();
+    return job.id;
+}
+
+void CaptureJobTable::markPressed(uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_jobs.find(id);
+    if (it != m_jobs.end() && it->second.state == CaptureJobState::Pending) {
+        it->second.state = CaptureJobState::Pressed;
+        it->second.pressed = std::chrono::steady_clock::now();
+    }
+}
+
+void CaptureJobTable::markReleased(uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_jobs.find(id);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    // The download may already have arrived; never move a job backwards
+    it->second.released = std::chrono::steady_clock::now();
+    if (it->second.state == CaptureJobState::Pressed) {
+        it->second.state = CaptureJobState::Released;
+    }
+}
+
+void CaptureJobTable::markFailed(uint64_t id, const std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_jobs.find(id);
+        if (it == m_jobs.end() || it->second.isFinished()) {
+            return;
+        }
+        it->second.state = CaptureJobState::Failed;
+        it->second.error = error;
+    }
+    m_cv.notify_all();
+}
+
+void CaptureJobTable::onDownloadComplete(int cameraIndex, const std::string& filename) {
+    auto now = std::chrono::steady_clock::now();
+    std::string stem = stemOf(filename);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Another file of a shot that already delivered one
+        for (auto it = m_jobs.rbegin(); it != m_jobs.rend(); ++it) {
+            auto& job = it->second;
+            if (job.cameraIndex != cameraIndex || job.state != CaptureJobState::Downloaded) continue;
+            if (now - job.downloaded > kSiblingWindow) continue;
+            for (const auto& file : job.files) {
+                if (stemOf(file) == stem) {
+                    job.files.push_back(filename);
+                    return;
+                }
+            }
+        }
+
+        // Oldest job of this camera whose shutter was pressed and that has
+        // no file yet (std::map iterates in creation order)
+        for (auto& pair : m_jobs) {
+            auto& job = pair.second;
+            if (job.cameraIndex != cameraIndex) continue;
+            if (job.state != CaptureJobState::Pressed && job.state != CaptureJobState::Released) continue;
+            if (now - job.pressed > kDownloadMatchWindow) continue;
+
+            job.state = CaptureJobState::Downloaded;
+            job.filename = filename;
+            job.files.push_back(filename);
+            job.downloaded = now;
+            break;
+        }
+    }
+    m_cv.notify_all();
+}
+
+std::optional<CaptureJob> CaptureJobTable::get(uint64_t id) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_jobs.find(id);
+    if (it == m_jobs.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::optional<CaptureJob> CaptureJobTable::waitFor(uint64_t id, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto finishedOrGone = [this, id]() {
+        auto it = m_jobs.find(id);
+        return it == m_jobs.end() || it->second.isFinished();
+    };
+    m_cv.wait_for(lock, timeout, finishedOrGone);
+
+    auto it = m_jobs.find(id);
+    if (it == m_jobs.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+nlohmann::json CaptureJobTable::toJson(const CaptureJob& job) {
+    auto sinceCreated = [&job](std::chrono::steady_clock::time_point t) -> nlohmann::json {
+        if (t.time_since_epoch().count() == 0) {
+            return nullptr;
+        }
+        return std::chrono::duration<double, std::milli>(t - job.created).count();
+    };
+
+    nlohmann::json json;
+    json["jobId"] = job.id;
+    json["cameraIndex"] = job.cameraIndex;
+    json["state"] = stateName(job.state);
+    json["createdAt"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+        job.createdAt.time_since_epoch()).count();
+    json["pressedMs"] = sinceCreated(job.pressed);
+    json["releasedMs"] = sinceCreated(job.released);
+    json["downloadedMs"] = sinceCreated(job.downloaded);
+    if (!job.filename.empty()) {
+        json["filename"] = job.filename;
+    }
+    if (!job.files.empty()) {
+        json["files"] = job.files;
+    }
+    if (!job.error.empty()) {
+        json["error"] = job.error;
+    }
+    return json;
+}
+
+std::string CaptureJobTable::stateName(CaptureJobState state) {
+    switch (state) {
+        case CaptureJobState::Pending: return "pending";
+        case CaptureJobState::Pressed: return "pressed";
+        case CaptureJobState::Released: return "released";
+        case CaptureJobState::Downloaded: return "downloaded";
+        case CaptureJobState::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+void CaptureJobTable::prune() {
+    // Caller holds m_mutex. Drop the oldest jobs that can no longer change:
+    // finished ones, and shots whose download never came. Jobs still queued
+    // or waiting on the camera are kept however many there are.
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = m_jobs.begin(); it != m_jobs.end() && m_jobs.size() > kMaxJobs;) {
+        const auto& job = it->second;
+        bool undelivered = (job.state == CaptureJobState::Pressed || job.state == CaptureJobState::Released) &&
+                           now - job.pressed > kDownloadMatchWindow;
+        it = job.isFinished() || undelivered ? m_jobs.erase(it) : std::next(it);
+    }
+}
+
+std::string CaptureJobTable::stemOf(const std::string& filename) {
+    auto slash = filename.find_last_of("/\\");
+    std::string base = slash == std::string::npos ? filename : filename.substr(slash + 1);
+    return base.substr(0, base.find_last_of('.'));
+}
+
+} // namespace crsdk_rest
@@ -0,0 +1,360 @@
+#include "camera/CaptureSequencer.h"
+#include <iostream>
+#include <algorithm>
+
+namespace crsdk_rest {
+
+CaptureSequencer::CaptureSequencer(CameraLookup lookup, CaptureJobTable& jobs, EventFn emit)
+    : m_lookup(std::move(lookup))
+    , m_jobs(jobs)
+    , m_emit(std::move(emit))
+{
+}
+
+CaptureSequencer::~CaptureSequencer() {
+    stop();
+}
+
+uint64_t CaptureSequencer::start(int cameraIndex, const SequenceOptions& options) {
+    std::vector<std::thread> pruned;
+    uint64_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) {
+            return 0;
+        }
+
+        for (const auto& pair : m_runners) {
+            const auto& seq = pair.second->sequence;
+            if (seq.cameraIndex == cameraIndex && !seq.isFinished()) {
+                return 0;
+            }
+        }
+
+        auto runner = std::make_shared<Runner>();
+        auto& seq = runner->sequence;
+        seq.id = m_nextId++;
+        seq.cameraIndex = cameraIndex;
+        seq.options = options;
+        seq.createdAt = std::chrono::system_clock::now();
+
+        // Anchor the wall-clock start time on the monotonic clock once, so
+        // later clock adjustments cannot move the schedule
+        seq.origin = std::chrono::steady_clock::now();
+        if (options.startAt > 0) {
+            auto startAt = std::chrono::system_clock::time_point(std::chrono::milliseconds(options.startAt));
+            auto delay = startAt - seq.createdAt;
+            if (delay > std::chrono::system_clock::duration::zero()) {
+                seq.origin += std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay);
+            }
+        }
+
+        id = seq.id;
+        m_runners[id] = runner;
+        runner->thread = std::thread(&CaptureSequencer::runSequence, this, runner);
+        pruned = prune();
+    }
+
+    for (auto& thread : pruned) {
+        thread.join();
+    }
+
+    std::cout << "[CaptureSequencer] Sequence " << id << " on camera " << cameraIndex
+              << ": " << options.count << " frames every " << options.intervalMs << " ms\n";
+    return id;
+}
+
+bool CaptureSequencer::pause(uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_runners.find(id);
+    if (it == m_runners.end()) {
+        return false;
+    }
+
+    auto& seq = it->second->sequence;
+    if (seq.isFinished() || seq.pauseRequested) {
+        return false;
+    }
+    seq.pauseRequested = true;
+    seq.pausedAt = std::chrono::steady_clock::now();
+    seq.state = SequenceState::Paused;
+    m_cv.notify_all();
+    return true;
+}
+
+bool CaptureSequencer::resume(uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_runners.find(id);
+    if (it == m_runners.end()) {
+        return false;
+    }
+
+    auto& seq = it->second->sequence;
+    if (seq.isFinished() || !seq.pauseRequested) {
+        return false;
+    }
+
+    // Shift the whole schedule by the pause so the interval phase is kept
+    auto now = std::chrono::steady_clock::now();
+    seq.origin += now - seq.pausedAt;
+    seq.pauseRequested = false;
+    bool started = seq.framesCaptured + seq.framesFailed > 0 || now >= seq.origin;
+    seq.state = started ? SequenceState::Running : SequenceState::Scheduled;
+    m_cv.notify_all();
+    return true;
+}
+
+bool CaptureSequencer::cancel(uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_runners.find(id);
+    if (it == m_runners.end() || it->second->sequence.isFinished()) {
+        return false;
+    }
+    it->second->sequence.cancelRequested = true;
+    m_cv.notify_all();
+    return true;
+}
+
+void CaptureSequencer::stop() {
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        for (auto& pair : m_runners) {
+            pair.second->sequence.cancelRequested = true;
+            if (pair.second->thread.joinable()) {
+                threads.push_back(std::move(pair.second->thread));
+            }
+        }
+    }
+    m_cv.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+nlohmann::json CaptureSequencer::get(uint64_t id, bool includeFrames) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_runners.find(id);
+    if (it == m_runners.end()) {
+        return nullptr;
+    }
+    return toJson(it->second->sequence, includeFrames);
+}
+
+nlohmann::json CaptureSequencer::list() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    nlohmann::json sequences = nlohmann::json::array();
+    for (const auto& pair : m_runners) {
+        sequences.push_back(toJson(pair.second->sequence, false));
+    }
+    return sequences;
+}
+
+std::string CaptureSequencer::stateName(SequenceState state) {
+    switch (state) {
+        case SequenceState::Scheduled: return "scheduled";
+        case SequenceState::Running: return "running";
+        case SequenceState::Paused: return "paused";
+        case SequenceState::Completed: return "completed";
+        case SequenceState::Cancelled: return "cancelled";
+        case SequenceState::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+void CaptureSequencer::runSequence(std::shared_ptr<Runner> runner) {
+    auto& seq = runner->sequence;
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    int consecutiveFailures = 0;
+    for (int frame = 0; frame < seq.options.count; frame++) {
+        if (!waitForFrame(lock, seq, frame)) {
+            finish(seq, SequenceState::Cancelled);
+            break;
+        }
+        if (seq.state == SequenceState::Scheduled) {
+            seq.state = SequenceState::Running;
+        }
+
+        // A burst has no schedule; lateness is then just the queue delay
+        auto deadline = seq.options.intervalMs > 0
+            ? seq.origin + std::chrono::milliseconds(static_cast<int64_t>(seq.options.intervalMs) * frame)
+            : std::chrono::steady_clock::now();
+        int cameraIndex = seq.cameraIndex;
+        lock.unlock();
+
+        SequenceFrame record;
+        record.frame = frame;
+
+        auto camera = m_lookup(cameraIndex);
+        if (camera && camera->isConnected()) {
+            uint64_t jobId = m_jobs.create(cameraIndex);
+            record.jobId = jobId;
+
+            // Written on the queue thread; read after the future resolves
+            auto pressedAt = std::make_shared<std::chrono::steady_clock::time_point>();
+            auto releasedAt = std::make_shared<std::chrono::steady_clock::time_point>();
+            auto released = camera->captureAsync(
+                [this, jobId, pressedAt](bool ok) {
+                    *pressedAt = std::chrono::steady_clock::now();
+                    if (ok) {
+                        m_jobs.markPressed(jobId);
+                    } else {
+                        m_jobs.markFailed(jobId, "Shutter press failed");
+                    }
+                },
+                [this, jobId, releasedAt](bool ok) {
+                    *releasedAt = std::chrono::steady_clock::now();
+                    if (ok) {
+                        m_jobs.markReleased(jobId);
+                    } else {
+                        m_jobs.markFailed(jobId, "Shutter release failed");
+                    }
+                });
+
+            try {
+                record.captured = released.get();
+            } catch (const std::exception& e) {
+                m_jobs.markFailed(jobId, e.what());
+            }
+
+            if (pressedAt->time_since_epoch().count() != 0) {
+                record.latenessMs = std::chrono::duration<double, std::milli>(*pressedAt - deadline).count();
+            }
+            if (releasedAt->time_since_epoch().count() != 0) {
+                record.captureMs = std::chrono::duration<double, std::milli>(*releasedAt - *pressedAt).count();
+            }
+        }
+
+        lock.lock();
+        if (record.captured) {
+            seq.framesCaptured++;
+            seq.totalLatenessMs += record.latenessMs;
+            seq.maxLatenessMs = std::max(seq.maxLatenessMs, record.latenessMs);
+            consecutiveFailures = 0;
+        } else {
+            seq.framesFailed++;
+            consecutiveFailures++;
+        }
+        seq.recentFrames.push_back(record);
+        if (seq.recentFrames.size() > kRecentFrames) {
+            seq.recentFrames.pop_front();
+        }
+
+        if (consecutiveFailures >= kMaxConsecutiveFailures) {
+            finish(seq, SequenceState::Failed, "Camera " + std::to_string(cameraIndex) + " stopped capturing");
+            break;
+        }
+    }
+
+    if (!seq.isFinished()) {
+        finish(seq, SequenceState::Completed);
+    }
+
+    CameraEvent event("sequence_complete", seq.cameraIndex);
+    event.data = toJson(seq, false);
+    lock.unlock();
+
+    std::cout << "[CaptureSequencer] Sequence " << event.data["sequenceId"] << " "
+              << event.data["state"].get<std::string>() << "\n";
+    m_emit(event);
+}
+
+bool CaptureSequencer::waitForFrame(std::unique_lock<std::mutex>& lock, CaptureSequence& seq, int frame) {
+    while (true) {
+        if (seq.cancelRequested) {
+            return false;
+        }
+        if (seq.pauseRequested) {
+            m_cv.wait(lock);
+            continue;
+        }
+
+        // Absolute deadline: time spent capturing earlier frames is absorbed
+        // instead of accumulating
+        auto deadline = seq.origin + std::chrono::milliseconds(static_cast<int64_t>(seq.options.intervalMs) * frame);
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return true;
+        }
+        m_cv.wait_until(lock, deadline);
+    }
+}
+
+void CaptureSequencer::finish(CaptureSequence& seq, SequenceState state, const std::string& error) {
+    // Caller holds m_mutex
+    seq.state = state;
+    seq.error = error;
+    seq.pauseRequested = false;
+}
+
+std::vector<std::thread> CaptureSequencer::prune() {
+    // Caller holds m_mutex. Drop the oldest finished sequences; their threads
+    // are handed back to be joined after unlocking.
+    std::vector<std::thread> threads;
+    size_t finished = 0;
+    for (const auto& pair : m_runners) {
+        if (pair.second->sequence.isFinished()) {
+            finished++;
+        }
+    }
+
+    for (auto it = m_runners.begin(); it != m_runners.end() && finished > kMaxFinished;) {
+        if (it->second->sequence.isFinished()) {
+            if (it->second->thread.joinable()) {
+                threads.push_back(std::move(it->second->thread));
+            }
+            it = m_runners.erase(it);
+            finished--;
+        } else {
+            ++it;
+        }
+    }
+    return threads;
+}
+
+nlohmann::json CaptureSequencer::toJson(const CaptureSequence& seq, bool includeFrames) {
+    nlohmann::json json;
+    json["sequenceId"] = seq.id;
+    json["cameraIndex"] = seq.cameraIndex;
+    json["state"] = stateName(seq.state);
+    json["count"] = seq.options.count;
+    json["intervalMs"] = seq.options.intervalMs;
+    json["createdAt"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+        seq.createdAt.time_since_epoch()).count();
+    json["framesCaptured"] = seq.framesCaptured;
+    json["framesFailed"] = seq.framesFailed;
+    json["framesRemaining"] = seq.options.count - seq.framesCaptured - seq.framesFailed;
+    json["lateness"] = {
+        {"meanMs", seq.framesCaptured > 0 ? seq.totalLatenessMs / seq.framesCaptured : 0.0},
+        {"maxMs", seq.maxLatenessMs}
+    };
+
+    if (seq.state == SequenceState::Scheduled || seq.state == SequenceState::Running) {
+        int next = seq.framesCaptured + seq.framesFailed;
+        auto due = seq.origin + std::chrono::milliseconds(static_cast<int64_t>(seq.options.intervalMs) * next);
+        json["nextFrameInMs"] = std::max(0.0, std::chrono::duration<double, std::milli>(
+            due - std::chrono::steady_clock::now()).count());
+    }
+    if (!seq.error.empty()) {
+        json["error"] = seq.error;
+    }
+
+    if (includeFrames) {
+        nlohmann::json frames = nlohmann::json::array();
+        for (const auto& frame : seq.recentFrames) {
+            frames.push_back({
+                {"frame", frame.frame},
+                {"jobId", frame.jobId},
+                {"captured", frame.captured},
+                {"latenessMs", frame.latenessMs},
+                {"captureMs", frame.captureMs}
+            });
+        }
+        json["frames"] = frames;
+    }
+    return json;
+}
+
+} // namespace crsdk_rest
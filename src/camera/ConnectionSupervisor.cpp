@@ -0,0 +1,268 @@
+#include "camera/ConnectionSupervisor.h"
+#include <iostream>
+#include <algorithm>
+
+namespace crsdk_rest {
+
+ConnectionSupervisor::ConnectionSupervisor(RecoverFn recover, EventFn emit, StallCheckFn stallCheck)
+    : m_recover(std::move(recover))
+    , m_emit(std::move(emit))
+    , m_stallCheck(std::move(stallCheck))
+{
+}
+
+ConnectionSupervisor::~ConnectionSupervisor() {
+    stop();
+}
+
+void ConnectionSupervisor::watch(int cameraIndex) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    SessionHealth health;
+    health.stateSince = std::chrono::steady_clock::now();
+    m_sessions[cameraIndex] = health;
+
+    // Started on first use so the singleton costs nothing without cameras
+    if (!m_thread.joinable() && !m_stopping) {
+        m_thread = std::thread(&ConnectionSupervisor::supervisorLoop, this);
+    }
+}
+
+void ConnectionSupervisor::unwatch(int cameraIndex) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sessions.erase(cameraIndex);
+}
+
+void ConnectionSupervisor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void ConnectionSupervisor::onConnected(int cameraIndex) {
+    std::vector<CameraEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_sessions.find(cameraIndex);
+        if (it == m_sessions.end() || it->second.recovering) {
+            return;
+        }
+
+        auto& health = it->second;
+        if (health.state == SessionState::Degraded || health.state == SessionState::Reconnecting) {
+            // The SDK's own reconnect brought the session back
+            health.recoveries++;
+            health.lastOutageMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - health.outageStart).count();
+            health.attempts = 0;
+            setState(cameraIndex, health, SessionState::Connected, events);
+        }
+    }
+
+    for (const auto& event : events) {
+        m_emit(event);
+    }
+}
+
+void ConnectionSupervisor::onDisconnected(int cameraIndex, uint32_t error) {
+    std::vector<CameraEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_sessions.find(cameraIndex);
+        if (it == m_sessions.end() || it->second.recovering) {
+            return;
+        }
+
+        auto& health = it->second;
+        health.lastError = error;
+        if (health.state == SessionState::Connected) {
+            health.outageStart = std::chrono::steady_clock::now();
+            health.attempts = 0;
+            health.nextAttempt = health.outageStart + kGracePeriod;
+            setState(cameraIndex, health, SessionState::Degraded, events);
+        }
+    }
+    m_cv.notify_all();
+
+    for (const auto& event : events) {
+        m_emit(event);
+    }
+}
+
+void ConnectionSupervisor::supervisorLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stopping) {
+        if (m_stallCheck) {
+            lock.unlock();
+            checkStalls();
+            lock.lock();
+            if (m_stopping) {
+                break;
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        auto wakeAt = now + (m_stallCheck ? kStallCheckInterval : std::chrono::milliseconds(1000));
+        int due = -1;
+
+        for (auto& pair : m_sessions) {
+            auto& health = pair.second;
+            if (health.state != SessionState::Degraded && health.state != SessionState::Reconnecting) {
+                continue;
+            }
+            if (health.nextAttempt <= now) {
+                due = pair.first;
+                break;
+            }
+            wakeAt = std::min(wakeAt, health.nextAttempt);
+        }
+
+        if (due < 0) {
+            m_cv.wait_until(lock, wakeAt);
+            continue;
+        }
+
+        std::vector<CameraEvent> events;
+        auto& health = m_sessions[due];
+        health.attempts++;
+        health.recovering = true;
+        int attempt = health.attempts;
+        setState(due, health, SessionState::Reconnecting, events);
+
+        // Restore outside the lock; it blocks for up to the connect timeout
+        lock.unlock();
+        for (const auto& event : events) {
+            m_emit(event);
+        }
+        events.clear();
+
+        std::cout << "[Supervisor] Camera " << due << " reconnect attempt " << attempt << "\n";
+        bool restored = m_recover(due);
+        lock.lock();
+
+        auto it = m_sessions.find(due);
+        if (it == m_sessions.end()) {
+            continue;  // Unwatched (explicit disconnect) while restoring
+        }
+
+        auto& current = it->second;
+        current.recovering = false;
+        now = std::chrono::steady_clock::now();
+
+        if (restored) {
+            current.recoveries++;
+            current.lastOutageMs = std::chrono::duration<double, std::milli>(now - current.outageStart).count();
+            current.attempts = 0;
+            setState(due, current, SessionState::Connected, events);
+        } else if (current.attempts >= kMaxAttempts) {
+            setState(due, current, SessionState::Failed, events);
+        } else {
+            auto backoff = std::min(kMaxBackoff, kInitialBackoff * (1 << std::min(current.attempts - 1, 16)));
+            current.nextAttempt = now + backoff;
+        }
+
+        lock.unlock();
+        for (const auto& event : events) {
+            m_emit(event);
+        }
+        lock.lock();
+    }
+}
+
+void ConnectionSupervisor::checkStalls() {
+    std::vector<int> stalled = m_stallCheck();
+    if (stalled.empty()) {
+        return;
+    }
+
+    std::vector<CameraEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int cameraIndex : stalled) {
+            auto it = m_sessions.find(cameraIndex);
+            if (it == m_sessions.end()) {
+                continue;
+            }
+
+            auto& health = it->second;
+            health.stalls++;
+            if (health.state == SessionState::Connected) {
+                // No grace period: the SDK will not notice a hang by itself
+                health.outageStart = std::chrono::steady_clock::now();
+                health.attempts = 0;
+                health.nextAttempt = health.outageStart;
+                setState(cameraIndex, health, SessionState::Degraded, events);
+            }
+        }
+    }
+
+    for (const auto& event : events) {
+        m_emit(event);
+    }
+}
+
+void ConnectionSupervisor::setState(int cameraIndex, SessionHealth& health, SessionState state,
+                                    std::vector<CameraEvent>& events) {
+    health.state = state;
+    health.stateSince = std::chrono::steady_clock::now();
+
+    CameraEvent event("session_state", cameraIndex);
+    event.data = {{"state", stateName(state)}, {"attempts", health.attempts}};
+    events.push_back(event);
+
+    std::cout << "[Supervisor] Camera " << cameraIndex << " -> " << stateName(state) << "\n";
+}
+
+nlohmann::json ConnectionSupervisor::getHealth(int cameraIndex) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_sessions.find(cameraIndex);
+    if (it == m_sessions.end()) {
+        return nullptr;
+    }
+
+    const auto& health = it->second;
+    auto now = std::chrono::steady_clock::now();
+    auto msSince = [now](std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration<double, std::milli>(now - t).count();
+    };
+
+    nlohmann::json json;
+    json["state"] = stateName(health.state);
+    json["stateForMs"] = msSince(health.stateSince);
+    json["attempts"] = health.attempts;
+    json["recoveries"] = health.recoveries;
+    json["lastError"] = health.lastError;
+    json["lastOutageMs"] = health.lastOutageMs;
+    json["stalls"] = health.stalls;
+    if (health.state == SessionState::Degraded || health.state == SessionState::Reconnecting) {
+        json["outageMs"] = msSince(health.outageStart);
+        json["nextAttemptInMs"] = std::max(0.0, -msSince(health.nextAttempt));
+    }
+    return json;
+}
+
+std::string ConnectionSupervisor::getStateName(int cameraIndex) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_sessions.find(cameraIndex);
+    return it == m_sessions.end() ? "disconnected" : stateName(it->second.state);
+}
+
+std::string ConnectionSupervisor::stateName(SessionState state) {
+    switch (state) {
+        case SessionState::Connected: return "connected";
+        case SessionState::Degraded: return "degraded";
+        case SessionState::Reconnecting: return "reconnecting";
+        case SessionState::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+} // namespace crsdk_rest
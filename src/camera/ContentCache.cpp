@@ -0,0 +1,372 @@
+#include "camera/ContentCache.h"
+#include "util/FileUtil.h"
+#include "util/Xxh64.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace crsdk_rest {
+
+bool ContentCache::open(const std::string& dir, uint64_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = budgetBytes;
+    if (m_budget == 0) {
+        std::cout << "[ContentCache] Disabled\n";
+        return true;
+    }
+
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "[ContentCache] Could not create " << dir << ": " << std::strerror(errno) << "\n";
+        m_budget = 0;
+        return false;
+    }
+    m_dir = dir;
+
+    // Index lines: file, size, name, key and hash (tab separated; older
+    // indexes have no hash), most recent first. Journal lines are the same
+    // fields behind "+", or a key behind "-" for a removal, oldest first.
+    // Entries whose file is gone or has the wrong size are dropped.
+    std::ifstream index(m_dir + "/" + kIndexFile);
+    std::string line;
+    while (std::getline(index, line)) {
+        std::istringstream fields(line);
+        Entry entry;
+        if (parseEntry(fields, entry)) {
+            loadEntry(std::move(entry), false);
+        }
+    }
+
+    std::ifstream journalIn(m_dir + "/" + kJournalFile);
+    while (std::getline(journalIn, line)) {
+        std::istringstream fields(line.size() > 2 ? line.substr(2) : "");
+        Entry entry;
+        if (line.compare(0, 2, "+\t") == 0 && parseEntry(fields, entry)) {
+            loadEntry(std::move(entry), true);
+        } else if (line.compare(0, 2, "-\t") == 0) {
+            auto it = m_entries.find(line.substr(2));
+            if (it != m_entries.end()) {
+                m_bytes -= it->second->size;
+                m_lru.erase(it->second);
+                m_entries.erase(it);
+            }
+        }
+    }
+
+    // Cache files not in the index are left from a crash between write and
+    // index, or were evicted just before one; anything else is not ours
+    std::unordered_set<std::string> indexed;
+    for (const auto& entry : m_lru) {
+        indexed.insert(entry.file);
+    }
+    size_t orphans = 0;
+    if (DIR* handle = opendir(m_dir.c_str())) {
+        while (dirent* entry = readdir(handle)) {
+            std::string name = entry->d_name;
+            bool temporary = name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0;
+            bool cacheFile = name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0 &&
+                             name.find_first_not_of("0123456789") == name.size() - 4;
+            if ((!temporary && !cacheFile) || indexed.count(name) != 0) {
+                continue;
+            }
+            unlink((m_dir + "/" + name).c_str());
+            orphans++;
+        }
+        closedir(handle);
+    }
+
+    // The budget may have shrunk since the last run
+    while (m_bytes > m_budget && !m_lru.empty()) {
+        const auto& entry = m_lru.back();
+        unlink((m_dir + "/" + entry.file).c_str());
+        m_bytes -= entry.size;
+        m_entries.erase(entry.key);
+        m_lru.pop_back();
+    }
+    persist();
+
+    std::cout << "[ContentCache] " << m_lru.size() << " entries, " << m_bytes / (1024 * 1024) << " of "
+              << m_budget / (1024 * 1024) << " MB in " << m_dir;
+    if (orphans > 0) {
+        std::cout << " (removed " << orphans << " orphaned files)";
+    }
+    std::cout << "\n";
+    return true;
+}
+
+void ContentCache::close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_budget > 0) {
+        persist();
+    }
+    m_journal.close();
+}
+
+bool ContentCache::isEnabled() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budget > 0;
+}
+
+std::string ContentCache::keyFor(const std::string& cameraIdentity, uint32_t contentHandle,
+                                 const std::string& modified, uint64_t size, Kind kind) {
+    std::string prefix = cameraIdentity + "/" + std::to_string(contentHandle) + "/";
+    std::string suffix = kind == Kind::Original ? "/original" : "/thumbnail";
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (cameraIdentity.empty() || m_budget == 0) {
+        return "";
+    }
+    if (!modified.empty()) {
+        return prefix + modified + "/" + std::to_string(size) + suffix;
+    }
+
+    // Entries outlive the process, so the token has to be unique across
+    // restarts as well
+    auto& token = m_sessions[cameraIdentity];
+    if (token.empty()) {
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        token = "session-" + std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+    }
+    return prefix + token + suffix;
+}
+
+void ContentCache::forgetSession(const std::string& cameraIdentity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sessions.erase(cameraIdentity);
+}
+
+std::optional<CachedFile> ContentCache::lookup(const std::string& key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        m_misses++;
+        return std::nullopt;
+    }
+
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    m_hits++;
+
+    const auto& entry = *it->second;
+    return CachedFile{m_dir + "/" + entry.file, entry.name, entry.size, entry.hash};
+}
+
+bool ContentCache::insertFile(const std::string& key, const std::string& sourcePath, const std::string& name,
+                              const std::string& hash) {
+    std::string file;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_budget == 0) {
+            return false;
+        }
+        file = nextFileName();
+    }
+
+    std::string tmpPath = m_dir + "/" + file + ".tmp";
+    if (!linkOrCopyFile(sourcePath, tmpPath)) {
+        std::cerr << "[ContentCache] Could not store " << sourcePath << "\n";
+        return false;
+    }
+
+    struct stat st, source;
+    if (stat(tmpPath.c_str(), &st) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+
+    // A link is the same inode; a copy has to read back as the same bytes
+    bool copied = stat(sourcePath.c_str(), &source) != 0 || source.st_ino != st.st_ino || source.st_dev != st.st_dev;
+    uint64_t digest = 0;
+    if (!hash.empty() && copied && (!Xxh64::hashFile(tmpPath, digest) || Xxh64::format(digest) != hash)) {
+        std::cerr << "[ContentCache] Copy of " << sourcePath << " does not match " << hash << "\n";
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return commit(key, tmpPath, file, name, static_cast<uint64_t>(st.st_size), hash);
+}
+
+bool ContentCache::insertData(const std::string& key, const std::vector<uint8_t>& data) {
+    std::string file;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_budget == 0) {
+            return false;
+        }
+        file = nextFileName();
+    }
+
+    std::string tmpPath = m_dir + "/" + file + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            unlink(tmpPath.c_str());
+            return false;
+        }
+    }
+    return commit(key, tmpPath, file, "", data.size(), "");
+}
+
+nlohmann::json ContentCache::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    nlohmann::json stats;
+    stats["enabled"] = m_budget > 0;
+    stats["directory"] = m_dir;
+    stats["budgetBytes"] = m_budget;
+    stats["bytes"] = m_bytes;
+    stats["entries"] = m_lru.size();
+    stats["hits"] = m_hits;
+    stats["misses"] = m_misses;
+    stats["evictions"] = m_evictions;
+    return stats;
+}
+
+bool ContentCache::commit(const std::string& key, const std::string& tmpPath, const std::string& file,
+                          const std::string& name, uint64_t size, const std::string& hash) {
+    std::vector<std::string> removed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (size > m_budget || std::rename(tmpPath.c_str(), (m_dir + "/" + file).c_str()) != 0) {
+            unlink(tmpPath.c_str());
+            return false;
+        }
+
+        auto existing = m_entries.find(key);
+        if (existing != m_entries.end()) {
+            removed.push_back(m_dir + "/" + existing->second->file);
+            m_bytes -= existing->second->size;
+            m_lru.erase(existing->second);
+            m_entries.erase(existing);
+        }
+
+        m_lru.push_front(Entry{key, file, name, size, hash});
+        m_entries[key] = m_lru.begin();
+        m_bytes += size;
+        journal(m_lru.front());
+
+        while (m_bytes > m_budget && m_lru.size() > 1) {
+            const auto& victim = m_lru.back();
+            journal(Entry{victim.key, "", "", 0, ""});
+            removed.push_back(m_dir + "/" + victim.file);
+            m_bytes -= victim.size;
+            m_entries.erase(victim.key);
+            m_lru.pop_back();
+            m_evictions++;
+        }
+
+        // Journal first: a crash before the unlinks only leaves orphans,
+        // which open() removes
+        if (m_journalLines > m_lru.size() + kJournalSlack) {
+            persist();
+        }
+    }
+
+    // Responses still streaming an evicted file keep their mapping
+    for (const auto& path : removed) {
+        unlink(path.c_str());
+    }
+    return true;
+}
+
+bool ContentCache::parseEntry(std::istream& fields, Entry& entry) {
+    std::string size;
+    if (!std::getline(fields, entry.file, '\t') || !std::getline(fields, size, '\t') ||
+        !std::getline(fields, entry.name, '\t') || !std::getline(fields, entry.key, '\t')) {
+        return false;
+    }
+    std::getline(fields, entry.hash);
+    entry.size = std::strtoull(size.c_str(), nullptr, 10);
+    return !entry.key.empty();
+}
+
+bool ContentCache::loadEntry(Entry entry, bool front) {
+    struct stat st;
+    std::string path = m_dir + "/" + entry.file;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || static_cast<uint64_t>(st.st_size) != entry.size) {
+        return false;
+    }
+
+    // The index lists each key once; the journal replaces earlier inserts
+    auto existing = m_entries.find(entry.key);
+    if (existing != m_entries.end()) {
+        if (!front) {
+            return false;
+        }
+        m_bytes -= existing->second->size;
+        m_lru.erase(existing->second);
+        m_entries.erase(existing);
+    }
+
+    m_nextId = std::max<uint64_t>(m_nextId, std::strtoull(entry.file.c_str(), nullptr, 10) + 1);
+    m_bytes += entry.size;
+    if (front) {
+        m_lru.push_front(std::move(entry));
+        m_entries[m_lru.front().key] = m_lru.begin();
+    } else {
+        m_lru.push_back(std::move(entry));
+        m_entries[m_lru.back().key] = std::prev(m_lru.end());
+    }
+    return true;
+}
+
+std::string ContentCache::nextFileName() {
+    return std::to_string(m_nextId++) + ".bin";
+}
+
+void ContentCache::journal(const Entry& entry) {
+    // Not open if the index could not be rewritten; keep appending then
+    if (!m_journal.is_open()) {
+        m_journal.clear();
+        m_journal.open(m_dir + "/" + kJournalFile, std::ios::app);
+    }
+    if (entry.file.empty()) {
+        m_journal << "-\t" << entry.key << '\n';
+    } else {
+        m_journal << "+\t" << entry.file << '\t' << entry.size << '\t' << entry.name << '\t' << entry.key << '\t'
+                  << entry.hash << '\n';
+    }
+    m_journal.flush();
+    if (!m_journal) {
+        std::cerr << "[ContentCache] Could not append to " << kJournalFile << "\n";
+        m_journal.clear();
+    }
+    m_journalLines++;
+}
+
+bool ContentCache::persist() {
+    std::string path = m_dir + "/" + kIndexFile;
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file) {
+            std::cerr << "[ContentCache] Could not write " << tmpPath << "\n";
+            return false;
+        }
+        for (const auto& entry : m_lru) {
+            file << entry.file << '\t' << entry.size << '\t' << entry.name << '\t' << entry.key << '\t'
+                 << entry.hash << '\n';
+        }
+        if (!file) {
+            return false;
+        }
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        return false;
+    }
+
+    // Replaying a journal the new index already covers changes nothing, so a
+    // crash before it is emptied is harmless
+    m_journal.close();
+    m_journal.clear();
+    m_journal.open(m_dir + "/" + kJournalFile, std::ios::trunc);
+    m_journalLines = 0;
+    return true;
+}
+
+} // namespace crsdk_rest
@@ -0,0 +1,299 @@
+#include "camera/ContentCatalog.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+namespace crsdk_rest {
+
+std::vector<uint32_t> ContentCatalog::setListing(const std::unordered_map<uint32_t, uint32_t>& listing) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_listed = listing;
+
+    std::vector<uint32_t> gone;
+    for (const auto& [handle, entry] : m_entries) {
+        if (m_listed.count(handle) == 0) {
+            gone.push_back(handle);
+        }
+    }
+    for (uint32_t handle : gone) {
+        removeLocked(handle);
+    }
+    for (auto it = m_hashes.begin(); it != m_hashes.end();) {
+        it = m_listed.count(it->first) == 0 ? m_hashes.erase(it) : std::next(it);
+    }
+
+    std::vector<uint32_t> missing;
+    for (const auto& [handle, folder] : m_listed) {
+        if (m_entries.count(handle) == 0) {
+            missing.push_back(handle);
+        }
+    }
+    // Handles grow with each shot, so this reads the card oldest first
+    std::sort(missing.begin(), missing.end());
+    return missing;
+}
+
+bool ContentCatalog::isListed(uint32_t handle) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_listed.count(handle) != 0;
+}
+
+bool ContentCatalog::get(uint32_t handle, CatalogEntry& entry) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(handle);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    entry = it->second;
+    return true;
+}
+
+void ContentCatalog::put(const CatalogEntry& entry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    removeLocked(entry.handle);
+
+    m_listed.emplace(entry.handle, entry.folder);
+    auto& stored = m_entries[entry.handle] = entry;
+    auto hash = m_hashes.find(entry.handle);
+    if (hash != m_hashes.end()) {
+        stored.hash = hash->second;
+    }
+    m_byDate[""].insert({entry.captured, entry.handle});
+    if (!entry.type.empty()) {
+        m_byDate[entry.type].insert({entry.captured, entry.handle});
+    }
+    m_byName.insert({lower(entry.name), entry.handle});
+}
+
+void ContentCatalog::setHash(uint32_t handle, const std::string& hash) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_hashes[handle] = hash;
+    auto it = m_entries.find(handle);
+    if (it != m_entries.end()) {
+        it->second.hash = hash;
+    }
+}
+
+void ContentCatalog::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_listed.clear();
+    m_entries.clear();
+    m_hashes.clear();
+    m_byDate.clear();
+    m_byName.clear();
+}
+
+bool ContentCatalog::query(const CatalogQuery& query, CatalogPage& page) const {
+    const bool byDate = query.sort == CatalogQuery::Sort::Date;
+    const char sortTag = byDate ? 'd' : 'n';
+
+    std::optional<Key> after;
+    if (!query.cursor.empty()) {
+        Key key;
+        if (!decodeCursor(query.cursor, sortTag, key)) {
+            return false;
+        }
+        after = key;
+    }
+
+    std::string type = query.type;
+    std::transform(type.begin(), type.end(), type.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    std::string prefix = lower(query.namePrefix);
+    // Every string starting with a prefix sorts below prefix + 0xFF
+    std::string toBound = query.to.empty() ? "" : query.to + '\xff';
+    size_t limit = std::min(std::max<size_t>(query.limit, 1), kMaxPageSize);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Walk the index of the sort order between the bounds it can answer;
+    // the other conditions are checked per entry
+    const std::set<Key>* index = &m_byName;
+    Key lo{prefix, 0};
+    Key hi{prefix + '\xff', 0};
+    bool hasHi = !prefix.empty();
+    if (byDate) {
+        auto it = m_byDate.find(type);
+        if (it == m_byDate.end()) {
+            return true;
+        }
+        index = &it->second;
+        lo = {query.from, 0};
+        hi = {toBound, 0};
+        hasHi = !query.to.empty();
+    }
+
+    auto matches = [&](const CatalogEntry& entry) {
+        if (!type.empty() && entry.type != type) return false;
+        if (query.folder && entry.folder != *query.folder) return false;
+        if (!prefix.empty() && lower(entry.name).compare(0, prefix.size(), prefix) != 0) return false;
+        if (!query.from.empty() && entry.captured < query.from) return false;
+        if (!query.to.empty() && entry.captured >= toBound) return false;
+        return true;
+    };
+
+    Key last;
+    auto take = [&](const Key& key) {
+        const auto& entry = m_entries.at(key.second);
+        if (!matches(entry)) {
+            return true;
+        }
+        if (page.items.size() == limit) {
+            page.nextCursor = encodeCursor(sortTag, last);
+            return false;
+        }
+        page.items.push_back(entry);
+        last = key;
+        return true;
+    };
+
+    if (!query.descending) {
+        auto it = (after && lo < *after) ? index->upper_bound(*after) : index->lower_bound(lo);
+        for (; it != index->end() && (!hasHi || *it < hi); ++it) {
+            if (!take(*it)) {
+                break;
+            }
+        }
+    } else {
+        auto it = hasHi ? index->lower_bound(hi) : index->end();
+        if (after && (!hasHi || *after < hi)) {
+            it = index->lower_bound(*after);
+        }
+        while (it != index->begin()) {
+            --it;
+            if (*it < lo || !take(*it)) {
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+size_t ContentCatalog::listedCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_listed.size();
+}
+
+size_t ContentCatalog::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+bool ContentCatalog::fromDetail(const nlohmann::json& detail, CatalogEntry& entry) {
+    if (!detail.is_object() || !detail.contains("fileName")) {
+        return false;
+    }
+    entry.handle = detail.value("handle", 0u);
+    entry.folder = detail.value("folderHandle", 0u);
+    entry.name = detail["fileName"].get<std::string>();
+    entry.size = detail.value("size", static_cast<uint64_t>(0));
+    entry.type = typeFor(entry.name);
+    entry.captured = normalizeTimestamp(detail.value("modified", ""));
+    return true;
+}
+
+nlohmann::json ContentCatalog::toJson(const CatalogEntry& entry) {
+    nlohmann::json json;
+    json["handle"] = entry.handle;
+    json["folderHandle"] = entry.folder;
+    json["fileName"] = entry.name;
+    json["size"] = entry.size;
+    json["type"] = entry.type;
+    json["captured"] = entry.captured.empty() ? nlohmann::json() : nlohmann::json(entry.captured);
+    json["hash"] = entry.hash.empty() ? nlohmann::json() : nlohmann::json(entry.hash);
+    return json;
+}
+
+std::string ContentCatalog::typeFor(const std::string& name) {
+    auto dot = name.find_last_of('.');
+    if (dot == std::string::npos) {
+        return "";
+    }
+    std::string ext = name.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    return ext;
+}
+
+std::string ContentCatalog::normalizeTimestamp(const std::string& raw) {
+    std::string d;
+    for (char c : raw) {
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            d += c;
+        }
+    }
+    if (d.size() < 14) {
+        return "";
+    }
+    return d.substr(0, 4) + "-" + d.substr(4, 2) + "-" + d.substr(6, 2) + "T" + d.substr(8, 2) + ":" +
+           d.substr(10, 2) + ":" + d.substr(12, 2) + "Z";
+}
+
+void ContentCatalog::removeLocked(uint32_t handle) {
+    auto it = m_entries.find(handle);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    const auto& entry = it->second;
+    for (const std::string& type : {std::string(), entry.type}) {
+        auto byType = m_byDate.find(type);
+        if (byType != m_byDate.end()) {
+            byType->second.erase({entry.captured, handle});
+            if (byType->second.empty()) {
+                m_byDate.erase(byType);
+            }
+        }
+    }
+    m_byName.erase({lower(entry.name), handle});
+    m_entries.erase(it);
+}
+
+std::string ContentCatalog::lower(const std::string& s) {
+    std::string out = s;
+    std::transform(out.begin(), out.end(), out.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return out;
+}
+
+// "<sort>.<hex of the sort key>.<handle>"; opaque to clients
+std::string ContentCatalog::encodeCursor(char sort, const Key& key) {
+    static const char* hex = "0123456789abcdef";
+    std::string cursor(1, sort);
+    cursor += '.';
+    for (unsigned char c : key.first) {
+        cursor += hex[c >> 4];
+        cursor += hex[c & 0xF];
+    }
+    cursor += '.' + std::to_string(key.second);
+    return cursor;
+}
+
+bool ContentCatalog::decodeCursor(const std::string& cursor, char sort, Key& key) {
+    auto dot = cursor.find('.', 2);
+    if (cursor.size() < 4 || cursor[0] != sort || cursor[1] != '.' || dot == std::string::npos ||
+        (dot - 2) % 2 != 0 || dot + 1 == cursor.size()) {
+        return false;
+    }
+
+    key.first.clear();
+    for (size_t i = 2; i < dot; i += 2) {
+        char pair[3] = {cursor[i], cursor[i + 1], 0};
+        char* end = nullptr;
+        long value = std::strtol(pair, &end, 16);
+        if (end != pair + 2) {
+            return false;
+        }
+        key.first += static_cast<char>(value);
+    }
+
+    std::string handle = cursor.substr(dot + 1);
+    if (handle.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    key.second = static_cast<uint32_t>(std::strtoul(handle.c_str(), nullptr, 10));
+    return true;
+}
+
+} // namespace crsdk_rest
@@ -0,0 +1,297 @@
+#include "camera/ContentSpool.h"
+#include "camera/CameraDeviceWrapper.h"
+#include "util/Xxh64.h"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace crsdk_rest {
+
+namespace {
+
+// Removes the files in dir (one level deep), then dir itself
+void removeDirectory(const std::string& dir) {
+    if (DIR* handle = opendir(dir.c_str())) {
+        while (dirent* entry = readdir(handle)) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                unlink((dir + "/" + name).c_str());
+            }
+        }
+        closedir(handle);
+    }
+    rmdir(dir.c_str());
+}
+
+std::string findFile(const std::string& dir) {
+    std::string found;
+    if (DIR* handle = opendir(dir.c_str())) {
+        while (dirent* entry = readdir(handle)) {
+            std::string path = dir + "/" + entry->d_name;
+            struct stat st;
+            if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+                found = path;
+                break;
+            }
+        }
+        closedir(handle);
+    }
+    return found;
+}
+
+} // namespace
+
+SpooledFile::~SpooledFile() {
+    if (!dir.empty()) {
+        removeDirectory(dir);
+    }
+}
+
+ContentSpool::~ContentSpool() {
+    close();
+}
+
+bool ContentSpool::open(const std::string& dir, uint64_t budgetBytes) {
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "[ContentSpool] Could not create " << dir << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // The SDK resolves relative paths against its own working directory
+    char resolved[PATH_MAX];
+    if (!realpath(dir.c_str(), resolved)) {
+        std::cerr << "[ContentSpool] Could not resolve " << dir << "\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dir = resolved;
+    m_budget = budgetBytes;
+
+    size_t stale = 0;
+    if (DIR* handle = opendir(m_dir.c_str())) {
+        while (dirent* entry = readdir(handle)) {
+            std::string name = entry->d_name;
+            if (name.compare(0, std::strlen(kPullPrefix), kPullPrefix) == 0) {
+                removeDirectory(m_dir + "/" + name);
+                stale++;
+            }
+        }
+        closedir(handle);
+    }
+
+    std::cout << "[ContentSpool] Spooling downloads in " << m_dir << ", keeping up to "
+              << m_budget / (1024 * 1024) << " MB";
+    if (stale > 0) {
+        std::cout << " (removed " << stale << " stale pulls)";
+    }
+    std::cout << "\n";
+
+    if (!m_sweeper.joinable()) {
+        m_stopping = false;
+        m_sweeper = std::thread(&ContentSpool::sweepLoop, this);
+    }
+    return true;
+}
+
+void ContentSpool::close() {
+    std::thread sweeper;
+    std::map<std::string, Entry> dropped;  // Deleted after unlocking
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        sweeper = std::move(m_sweeper);
+        dropped.swap(m_entries);
+        m_keptBytes = 0;
+    }
+    m_cv.notify_all();
+    if (sweeper.joinable()) {
+        sweeper.join();
+    }
+}
+
+std::shared_ptr<const SpooledFile> ContentSpool::acquire(CameraDeviceWrapper& camera,
+                                                         const std::string& cameraIdentity,
+                                                         uint32_t contentHandle, bool retain,
+                                                         const Admission& admit) {
+    std::string key = cameraIdentity + "/" + std::to_string(contentHandle);
+    std::vector<std::shared_ptr<const SpooledFile>> expired;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_dir.empty()) {
+            return nullptr;
+        }
+
+        expired = sweep();
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            it->second.lastUsed = std::chrono::steady_clock::now();
+            return it->second.file;
+        }
+    }
+
+    auto file = m_pulls.run(key, std::chrono::milliseconds(0), [&]() -> std::shared_ptr<const SpooledFile> {
+        auto ticket = admit ? admit() : nullptr;
+        if (admit && !ticket) {
+            return nullptr;
+        }
+        return pull(camera, cameraIdentity, contentHandle);
+    });
+
+    if (file && retain) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& entry = m_entries[key];
+        if (entry.file) {
+            m_keptBytes -= entry.file->size;
+        }
+        entry = Entry{file, std::chrono::steady_clock::now()};
+        m_keptBytes += file->size;
+        auto evicted = sweep();
+        expired.insert(expired.end(), evicted.begin(), evicted.end());
+    }
+    return file;
+}
+
+void ContentSpool::invalidate(const std::string& cameraIdentity) {
+    std::vector<std::shared_ptr<const SpooledFile>> dropped;  // Deleted after unlocking
+    std::string prefix = cameraIdentity + "/";
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                m_keptBytes -= it->second.file->size;
+                dropped.push_back(it->second.file);
+                it = m_entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    m_pulls.invalidatePrefix(prefix);
+}
+
+std::string ContentSpool::getDirectory() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dir;
+}
+
+std::string ContentSpool::makeETag(const std::string& cameraIdentity, uint32_t contentHandle, uint64_t size,
+                                   const std::string& modified) {
+    // FNV-1a keeps the identity (model and device id) out of the header; the
+    // modification time tells apart a file rewritten at the same size
+    uint64_t hash = 1469598103934665603ULL;
+    for (const std::string* part : {&cameraIdentity, &modified}) {
+        for (unsigned char c : *part) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        hash ^= '/';
+        hash *= 1099511628211ULL;
+    }
+
+    char buf[80];
+    std::snprintf(buf, sizeof(buf), "\"%016llx-%x-%llx\"", static_cast<unsigned long long>(hash),
+                  contentHandle, static_cast<unsigned long long>(size));
+    return buf;
+}
+
+std::shared_ptr<const SpooledFile> ContentSpool::pull(CameraDeviceWrapper& camera,
+                                                      const std::string& cameraIdentity,
+                                                      uint32_t contentHandle) {
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        dir = m_dir + "/" + kPullPrefix + std::to_string(camera.getIndex()) + "-" +
+              std::to_string(contentHandle) + "-" + std::to_string(m_nextId++);
+    }
+
+    if (mkdir(dir.c_str(), 0755) != 0) {
+        std::cerr << "[ContentSpool] Could not create " << dir << ": " << std::strerror(errno) << "\n";
+        return nullptr;
+    }
+
+    std::string path;
+    try {
+        path = camera.pullContentsFile(contentHandle, dir);
+    } catch (...) {
+        removeDirectory(dir);
+        throw;
+    }
+
+    struct stat st;
+    if (!path.empty() && stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        path = findFile(path);
+    }
+    if (path.empty() || stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        removeDirectory(dir);
+        return nullptr;
+    }
+
+    uint64_t digest = 0;
+    if (!Xxh64::hashFile(path, digest)) {
+        std::cerr << "[ContentSpool] Could not read back " << path << "\n";
+        removeDirectory(dir);
+        return nullptr;
+    }
+
+    auto file = std::make_shared<SpooledFile>();
+    file->dir = dir;
+    file->path = path;
+    file->name = path.substr(path.find_last_of('/') + 1);
+    file->size = static_cast<uint64_t>(st.st_size);
+    std::string modified;
+    uint64_t listedSize = 0;
+    camera.getContentVersion(contentHandle, modified, listedSize);
+    file->etag = makeETag(cameraIdentity, contentHandle, file->size, modified);
+    file->hash = Xxh64::format(digest);
+    camera.noteContentHash(contentHandle, file->hash);
+    return file;
+}
+
+std::vector<std::shared_ptr<const SpooledFile>> ContentSpool::sweep() {
+    std::vector<std::shared_ptr<const SpooledFile>> expired;
+    auto cutoff = std::chrono::steady_clock::now() - kRetention;
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->second.lastUsed < cutoff) {
+            m_keptBytes -= it->second.file->size;
+            expired.push_back(it->second.file);
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // A file still being streamed stays on disk until its response ends
+    while (m_keptBytes > m_budget && !m_entries.empty()) {
+        auto oldest = m_entries.begin();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->second.lastUsed < oldest->second.lastUsed) {
+                oldest = it;
+            }
+        }
+        m_keptBytes -= oldest->second.file->size;
+        expired.push_back(oldest->second.file);
+        m_entries.erase(oldest);
+    }
+    return expired;
+}
+
+void ContentSpool::sweepLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        m_cv.wait_for(lock, kSweepInterval, [this]() { return m_stopping; });
+        auto expired = sweep();
+        // Deleting the files takes a while; not under the lock
+        lock.unlock();
+        expired.clear();
+        lock.lock();
+    }
+}
+
+} // namespace crsdk_rest
@@ -0,0 +1,228 @@
+#include "camera/ContentStore.h"
+#include "util/FileUtil.h"
+#include "util/Xxh64.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace crsdk_rest {
+
+namespace {
+
+bool sameFile(const struct stat& a, const struct stat& b) {
+    return a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+}
+
+} // namespace
+
+bool ContentStore::open(const std::string& root) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string objects = root + "/" + kObjectDir;
+    if (mkdir(objects.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "[ContentStore] Could not create " << objects << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    m_root = root;
+    m_manifest.clear();
+
+    // Objects cut short by a previous run
+    if (DIR* shards = opendir(objects.c_str())) {
+        while (dirent* shard = readdir(shards)) {
+            std::string shardDir = objects + "/" + shard->d_name;
+            DIR* files = shard->d_name[0] != '.' ? opendir(shardDir.c_str()) : nullptr;
+            if (!files) {
+                continue;
+            }
+            while (dirent* file = readdir(files)) {
+                if (std::strstr(file->d_name, ".part-") != nullptr) {
+                    unlink((shardDir + "/" + file->d_name).c_str());
+                }
+            }
+            closedir(files);
+        }
+        closedir(shards);
+    }
+
+    // Appended to as files are stored; later lines win
+    std::ifstream in(root + "/" + kManifestFile);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string hash, size, dest;
+        if (std::getline(fields, hash, '\t') && std::getline(fields, size, '\t') && std::getline(fields, dest) &&
+            !dest.empty()) {
+            m_manifest[dest] = Record{hash, std::strtoull(size.c_str(), nullptr, 10)};
+        }
+    }
+    std::cout << "[ContentStore] " << m_manifest.size() << " files in " << objects << "\n";
+    return true;
+}
+
+std::string ContentStore::find(const std::string& dest, const std::string& hash) const {
+    // Variants are taken in order, so the first free name ends the search
+    for (int n = 0; n < kMaxVariants; n++) {
+        std::string name = variant(dest, n);
+        if (names(name, hash)) {
+            return name;
+        }
+        struct stat st;
+        if (stat(name.c_str(), &st) != 0) {
+            break;
+        }
+    }
+    return "";
+}
+
+bool ContentStore::ingest(const std::string& source, const std::string& hash, uint64_t size,
+                          std::string& dest, bool& duplicate, std::string& error) {
+    duplicate = false;
+    std::string object = objectPath(hash);
+    if (object.empty()) {
+        error = "Content store is not open";
+        return false;
+    }
+
+    if (!storeObject(source, hash, size, object, duplicate, error)) {
+        return false;
+    }
+
+    struct stat stored;
+    if (stat(object.c_str(), &stored) != 0) {
+        error = "Stored object disappeared: " + object;
+        return false;
+    }
+
+    // Linked under a temporary name first so a half-made copy never looks
+    // stored; link() rather than rename() so an existing name is never
+    // replaced
+    for (int n = 0; n < kMaxVariants; n++) {
+        std::string name = variant(dest, n);
+        struct stat named;
+        bool exists = stat(name.c_str(), &named) == 0;
+        if (exists && !sameFile(named, stored)) {
+            continue;  // Other bytes under this name
+        }
+        if (!exists) {
+            std::string partial = name + ".part";
+            unlink(partial.c_str());
+            if (!linkOrCopyFile(object, partial)) {
+                unlink(partial.c_str());
+                error = "Could not write " + name;
+                return false;
+            }
+            int linked = link(partial.c_str(), name.c_str());
+            int linkErrno = errno;
+            unlink(partial.c_str());
+            if (linked != 0) {
+                if (linkErrno == EEXIST) {
+                    continue;  // Taken since the check
+                }
+                error = "Could not write " + name + ": " + std::strerror(linkErrno);
+                return false;
+            }
+        }
+
+        dest = name;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        record(dest, Record{hash, size});
+        return true;
+    }
+    error = "No free name for " + dest;
+    return false;
+}
+
+std::string ContentStore::objectPath(const std::string& hash) const {
+    auto colon = hash.find(':');
+    std::string hex = colon == std::string::npos ? hash : hash.substr(colon + 1);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_root.empty() || hex.size() < 3) {
+        return "";
+    }
+    return m_root + "/" + kObjectDir + "/" + hex.substr(0, 2) + "/" + hex;
+}
+
+std::string ContentStore::variant(const std::string& dest, int n) {
+    if (n == 0) {
+        return dest;
+    }
+    size_t slash = dest.find_last_of('/');
+    size_t dot = dest.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash) || dot == slash + 1) {
+        dot = dest.size();
+    }
+    return dest.substr(0, dot) + "-" + std::to_string(n) + dest.substr(dot);
+}
+
+bool ContentStore::names(const std::string& dest, const std::string& hash) const {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_manifest.find(dest);
+        if (it == m_manifest.end() || it->second.hash != hash) {
+            return false;
+        }
+    }
+
+    // Replaced or edited since it was stored: no longer the same bytes
+    struct stat named, object;
+    return stat(dest.c_str(), &named) == 0 && stat(objectPath(hash).c_str(), &object) == 0 &&
+           sameFile(named, object);
+}
+
+bool ContentStore::storeObject(const std::string& source, const std::string& hash, uint64_t size,
+                               const std::string& object, bool& duplicate, std::string& error) {
+    struct stat st;
+    if (stat(object.c_str(), &st) == 0 && static_cast<uint64_t>(st.st_size) == size) {
+        duplicate = true;
+        return true;
+    }
+
+    std::string shard = object.substr(0, object.find_last_of('/'));
+    if (mkdir(shard.c_str(), 0755) != 0 && errno != EEXIST) {
+        error = "Could not create " + shard + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // Unique per call, since two cameras may store the same bytes at once
+    static std::atomic<uint64_t> nextTemp{1};
+    std::string partial = object + ".part-" + std::to_string(nextTemp++);
+    if (!linkOrCopyFile(source, partial)) {
+        unlink(partial.c_str());
+        error = "Could not store " + source;
+        return false;
+    }
+
+    // A hard link is the same inode; a copy is read back before it counts
+    struct stat from, to;
+    bool copied = stat(source.c_str(), &from) != 0 || stat(partial.c_str(), &to) != 0 || !sameFile(from, to);
+    uint64_t digest = 0;
+    if (copied && (!Xxh64::hashFile(partial, digest) || Xxh64::format(digest) != hash)) {
+        unlink(partial.c_str());
+        error = "Copy of " + source + " does not match " + hash;
+        return false;
+    }
+
+    if (std::rename(partial.c_str(), object.c_str()) != 0) {
+        unlink(partial.c_str());
+        error = "Could not store " + object;
+        return false;
+    }
+    return true;
+}
+
+void ContentStore::record(const std::string& dest, const Record& rec) {
+    m_manifest[dest] = rec;
+    std::ofstream out(m_root + "/" + kManifestFile, std::ios::app);
+    out << rec.hash << '\t' << rec.size << '\t' << dest << '\n';
+    if (!out) {
+        std::cerr << "[ContentStore] Could not update the manifest\n";
+    }
+}
+
+} // namespace crsdk_rest
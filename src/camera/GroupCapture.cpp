@@ -0,0 +1,121 @@
+#include "camera/GroupCapture.h"
+#include "camera/CameraDeviceWrapper.h"
+#include <algorithm>
+#include <cmath>
+
+namespace crsdk_rest {
+
+nlohmann::json GroupCapture::run(const std::vector<std::shared_ptr<CameraDeviceWrapper>>& cameras,
+                                 const GroupCaptureOptions& options) {
+    // Shared with the queued tasks, which may outlive this call on abort
+    auto gate = std::make_shared<SpinGate>();
+    std::vector<std::shared_ptr<ShotTiming>> timings;
+    std::vector<std::shared_future<bool>> shots;
+
+    for (const auto& camera : cameras) {
+        auto timing = std::make_shared<ShotTiming>();
+        timings.push_back(timing);
+        shots.push_back(camera->synchronizedCapture(gate, timing, options.halfPress, options.holdMs,
+                                                    options.armTimeoutMs));
+    }
+
+    // Wait until every camera is armed and spinning on the gate
+    int expected = static_cast<int>(cameras.size());
+    auto armStart = std::chrono::steady_clock::now();
+    auto deadline = armStart + std::chrono::milliseconds(options.armTimeoutMs);
+    while (gate->arrived() < expected && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    bool allArmed = gate->arrived() >= expected;
+    auto releasePoint = std::chrono::steady_clock::now();
+    if (allArmed) {
+        gate->open();
+        for (auto& shot : shots) {
+            shot.wait();
+        }
+    } else {
+        gate->abort();
+    }
+
+    nlohmann::json results = nlohmann::json::array();
+    std::vector<double> offsets;
+    bool allFired = allArmed;
+    nlohmann::json unsynchronized = nlohmann::json::array();
+
+    for (size_t i = 0; i < cameras.size(); i++) {
+        const auto& timing = *timings[i];
+
+        nlohmann::json result;
+        result["index"] = cameras[i]->getIndex();
+        result["armed"] = timing.armed.load();
+        if (options.halfPress) {
+            result["halfPressed"] = timing.halfPressed.load();
+            if (timing.armed.load() && !timing.halfPressed.load()) {
+                unsynchronized.push_back(cameras[i]->getIndex());
+            }
+        }
+
+        // A camera whose call overran its deadline is still firing
+        if (allArmed && !timing.finished.load()) {
+            result["pressed"] = false;
+            result["released"] = false;
+            allFired = false;
+        } else if (allArmed) {
+            double offsetUs = std::chrono::duration<double, std::micro>(timing.pressSent - releasePoint).count();
+            result["pressed"] = timing.pressed;
+            result["released"] = timing.released;
+            result["dispatchOffsetUs"] = offsetUs;
+            result["pressCallUs"] = timing.pressCallUs;
+            offsets.push_back(offsetUs);
+            allFired = allFired && timing.pressed && timing.released;
+        }
+        results.push_back(result);
+    }
+
+    nlohmann::json data;
+    data["captured"] = allFired;
+    data["armMs"] = std::chrono::duration<double, std::milli>(releasePoint - armStart).count();
+    data["cameras"] = results;
+    // Focus and metering ran after the release on these, so their exposure
+    // lags the dispatch skew below
+    data["synchronized"] = unsynchronized.empty();
+    if (!unsynchronized.empty()) {
+        data["unsynchronized"] = unsynchronized;
+    }
+
+    if (!allArmed) {
+        data["error"] = "Not all cameras armed within " + std::to_string(options.armTimeoutMs) + " ms";
+        return data;
+    }
+
+    if (offsets.empty()) {
+        data["error"] = "No camera finished its capture in time";
+        return data;
+    }
+
+    // Dispatch skew: spread of the SendCommand(Down) start times
+    auto [minIt, maxIt] = std::minmax_element(offsets.begin(), offsets.end());
+    double mean = 0;
+    for (double offset : offsets) {
+        mean += offset;
+    }
+    mean /= offsets.size();
+
+    double variance = 0;
+    for (double offset : offsets) {
+        variance += (offset - mean) * (offset - mean);
+    }
+    variance /= offsets.size();
+
+    data["skew"] = {
+        {"spreadUs", *maxIt - *minIt},
+        {"minOffsetUs", *minIt},
+        {"maxOffsetUs", *maxIt},
+        {"meanOffsetUs", mean},
+        {"stddevUs", std::sqrt(variance)}
+    };
+    return data;
+}
+
+} // namespace crsdk_rest
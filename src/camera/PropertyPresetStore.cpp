@@ -0,0 +1,216 @@
+#include "camera/PropertyPresetStore.h"
+#include "camera/CameraDeviceWrapper.h"
+#include "CameraRemote_SDK.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace crsdk_rest {
+
+namespace SDK = SCRSDK;
+
+bool PropertyPresetStore::load(const std::string& path) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_path = path;
+    m_presets.clear();
+
+    std::ifstream file(path);
+    if (!file) {
+        // Nothing saved yet
+        return true;
+    }
+
+    try {
+        auto json = nlohmann::json::parse(file);
+        for (const auto& item : json["presets"].items()) {
+            PropertyPreset preset;
+            preset.name = item.key();
+            preset.model = item.value().value("model", "");
+            preset.createdAt = std::chrono::system_clock::time_point(
+                std::chrono::milliseconds(item.value().value("createdAt", int64_t(0))));
+            for (const auto& prop : item.value()["properties"].items()) {
+                preset.properties[static_cast<uint32_t>(std::stoul(prop.key()))] = prop.value().get<uint64_t>();
+            }
+            m_presets[preset.name] = preset;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[PropertyPresetStore] Could not read " << path << ": " << e.what() << "\n";
+        return false;
+    }
+
+    std::cout << "[PropertyPresetStore] Loaded " << m_presets.size() << " presets from " << path << "\n";
+    return true;
+}
+
+std::optional<PropertyPreset> PropertyPresetStore::save(const std::string& name, CameraDeviceWrapper& camera,
+                                                        const std::vector<uint32_t>& codes) {
+    auto properties = codes.empty() ? camera.getAllProperties() : camera.getSelectProperties(codes);
+    if (properties.empty()) {
+        return std::nullopt;
+    }
+
+    PropertyPreset preset;
+    preset.name = name;
+    preset.model = camera.getModel();
+    preset.createdAt = std::chrono::system_clock::now();
+    for (const auto& prop : properties) {
+        uint32_t code = prop["code"].get<uint32_t>();
+        // The half-press lock is an action, not a setting
+        if (!prop["writable"].get<bool>() || code == SDK::CrDeviceProperty_S1) {
+            continue;
+        }
+        preset.properties[code] = prop["currentValue"].get<uint64_t>();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_presets[name] = preset;
+    persist();
+    return preset;
+}
+
+std::optional<PropertyPreset> PropertyPresetStore::get(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_presets.find(name);
+    if (it == m_presets.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::vector<PropertyPreset> PropertyPresetStore::list() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<PropertyPreset> presets;
+    for (const auto& pair : m_presets) {
+        presets.push_back(pair.second);
+    }
+    return presets;
+}
+
+bool PropertyPresetStore::remove(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_presets.erase(name) == 0) {
+        return false;
+    }
+    persist();
+    return true;
+}
+
+nlohmann::json PropertyPresetStore::apply(const std::string& name, CameraDeviceWrapper& camera) {
+    auto preset = get(name);
+    if (!preset) {
+        return nullptr;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Diff against what the camera holds now
+    std::map<uint32_t, uint64_t> current;
+    for (const auto& prop : camera.getAllProperties()) {
+        current[prop["code"].get<uint32_t>()] = prop["currentValue"].get<uint64_t>();
+    }
+
+    std::vector<std::pair<uint32_t, uint64_t>> changes;
+    for (const auto& pair : preset->properties) {
+        auto it = current.find(pair.first);
+        if (it == current.end() || it->second != pair.second) {
+            changes.push_back(pair);
+        }
+    }
+    std::stable_sort(changes.begin(), changes.end(), [](const auto& a, const auto& b) {
+        return applyRank(a.first) < applyRank(b.first);
+    });
+
+    nlohmann::json sent = nlohmann::json::array();
+    nlohmann::json failed = nlohmann::json::array();
+    for (const auto& change : changes) {
+        bool isMode = applyRank(change.first) == 0;
+        uint64_t seq = isMode ? camera.getPropertyChangeSeq(change.first) : 0;
+
+        if (!camera.setProperty(change.first, change.second)) {
+            failed.push_back(change.first);
+            continue;
+        }
+        sent.push_back(change.first);
+
+        if (isMode) {
+            camera.waitForPropertyChange(change.first, seq,
+                                         std::chrono::steady_clock::now() + kModeConfirmTimeout);
+        }
+    }
+
+    std::cout << "[Camera " << camera.getIndex() << "] Applied preset '" << name << "': "
+              << sent.size() << " sent, " << (preset->properties.size() - changes.size())
+              << " unchanged, " << failed.size() << " failed\n";
+
+    return {
+        {"preset", name},
+        {"sent", sent},
+        {"failed", failed},
+        {"unchanged", preset->properties.size() - changes.size()},
+        {"elapsedMs", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()}
+    };
+}
+
+nlohmann::json PropertyPresetStore::toJson(const PropertyPreset& preset, bool includeProperties) {
+    nlohmann::json json;
+    json["name"] = preset.name;
+    json["model"] = preset.model;
+    json["createdAt"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+        preset.createdAt.time_since_epoch()).count();
+    json["propertyCount"] = preset.properties.size();
+    if (includeProperties) {
+        nlohmann::json properties = nlohmann::json::object();
+        for (const auto& pair : preset.properties) {
+            properties[std::to_string(pair.first)] = pair.second;
+        }
+        json["properties"] = properties;
+    }
+    return json;
+}
+
+int PropertyPresetStore::applyRank(uint32_t code) {
+    // Exposure mode decides which exposure values are settable at all;
+    // drive, focus and white balance modes gate their own sub-settings
+    switch (code) {
+        case SDK::CrDeviceProperty_ExposureProgramMode:
+            return 0;
+        case SDK::CrDeviceProperty_DriveMode:
+        case SDK::CrDeviceProperty_FocusMode:
+        case SDK::CrDeviceProperty_WhiteBalance:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+bool PropertyPresetStore::persist() const {
+    if (m_path.empty()) {
+        return true;
+    }
+
+    nlohmann::json presets = nlohmann::json::object();
+    for (const auto& pair : m_presets) {
+        auto json = toJson(pair.second, true);
+        json.erase("name");
+        json.erase("propertyCount");
+        presets[pair.first] = json;
+    }
+
+    // Write a temp file and rename it so a crash never leaves half a file
+    std::string tmpPath = m_path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file) {
+            std::cerr << "[PropertyPresetStore] Could not write " << tmpPath << "\n";
+            return false;
+        }
+        file << nlohmann::json{{"presets", presets}}.dump(2);
+        if (!file) {
+            return false;
+        }
+    }
+    return std::rename(tmpPath.c_str(), m_path.c_str()) == 0;
+}
+
+} // namespace crsdk_rest
@@ -0,0 +1,65 @@
+#include "camera/ThumbnailCache.h"
+
+namespace crsdk_rest {
+
+void ThumbnailCache::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = bytes;
+    evict();
+}
+
+bool ThumbnailCache::isEnabled() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budget > 0;
+}
+
+std::optional<std::vector<uint8_t>> ThumbnailCache::get(uint32_t contentHandle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(contentHandle);
+    if (it == m_entries.end()) {
+        return std::nullopt;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->data;
+}
+
+bool ThumbnailCache::contains(uint32_t contentHandle) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.count(contentHandle) != 0;
+}
+
+void ThumbnailCache::put(uint32_t contentHandle, const std::vector<uint8_t>& data) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (data.empty() || data.size() > m_budget) {
+        return;
+    }
+
+    auto it = m_entries.find(contentHandle);
+    if (it != m_entries.end()) {
+        m_bytes -= it->second->data.size();
+        m_lru.erase(it->second);
+        m_entries.erase(it);
+    }
+
+    m_lru.push_front(Entry{contentHandle, data});
+    m_entries[contentHandle] = m_lru.begin();
+    m_bytes += data.size();
+    evict();
+}
+
+void ThumbnailCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lru.clear();
+    m_entries.clear();
+    m_bytes = 0;
+}
+
+void ThumbnailCache::evict() {
+    while (m_bytes > m_budget && !m_lru.empty()) {
+        m_bytes -= m_lru.back().data.size();
+        m_entries.erase(m_lru.back().handle);
+        m_lru.pop_back();
+    }
+}
+
+} // namespace crsdk_rest
@@ -0,0 +1,252 @@
+#include "camera/TransferScheduler.h"
+#include <algorithm>
+#include <iostream>
+
+namespace crsdk_rest {
+
+TransferTicket::~TransferTicket() {
+    m_owner.release(m_cameraIndex, m_class, m_id);
+}
+
+void TransferScheduler::setLimits(int readsPerCamera, int pullsPerCamera) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_limits[kReads] = std::max(readsPerCamera, 1);
+    m_limits[kPulls] = std::max(pullsPerCamera, 1);
+    for (auto& [index, lane] : m_lanes) {
+        for (int kind : {kReads, kPulls}) {
+            lane.pools[kind].limit = m_limits[kind];
+            dispatchLocked(lane.pools[kind]);
+        }
+    }
+}
+
+std::shared_ptr<TransferTicket> TransferScheduler::acquire(int cameraIndex, const std::string& client,
+                                                           TransferClass cls, const std::atomic<bool>* cancelled) {
+    auto waiter = std::make_shared<Waiter>();
+    waiter->client = client;
+    waiter->cls = cls;
+    waiter->queuedAt = std::chrono::steady_clock::now();
+
+    auto isCancelled = [cancelled]() { return cancelled && cancelled->load(); };
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_stopping || isCancelled()) {
+        return nullptr;
+    }
+
+    Pool& pool = poolLocked(cameraIndex, cls);
+    waiter->id = m_nextId++;
+
+    // A flow's next request starts where its previous one finishes in
+    // virtual time, or now if it has been idle; a heavier weight makes
+    // each request cost less of its share
+    std::string flow = std::string(className(cls)) + "/" + client;
+    auto last = pool.lastFinish.find(flow);
+    waiter->start = last != pool.lastFinish.end() ? std::max(pool.virtualTime, last->second) : pool.virtualTime;
+    pool.lastFinish[flow] = waiter->start + 1.0 / weightOf(cls);
+
+    pool.queued[waiter->id] = waiter;
+    dispatchLocked(pool);
+
+    auto wait = cls == TransferClass::Bulk
+        ? std::chrono::duration_cast<std::chrono::milliseconds>(kBulkWait)
+        : std::chrono::duration_cast<std::chrono::milliseconds>(kInteractiveWait);
+    m_cv.wait_for(lock, wait, [this, &waiter, &isCancelled]() {
+        return waiter->admitted || m_stopping || isCancelled();
+    });
+
+    if (!waiter->admitted) {
+        pool.queued.erase(waiter->id);
+        dropIfIdleLocked(cameraIndex);
+        std::cerr << "[TransferScheduler] Camera " << cameraIndex << ": " << className(cls) << " transfer for "
+                  << client << (m_stopping ? " dropped at shutdown"
+                                : isCancelled() ? " cancelled in the queue" : " timed out in the queue") << "\n";
+        return nullptr;
+    }
+
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(waiter->admittedAt - waiter->queuedAt);
+    return std::shared_ptr<TransferTicket>(new TransferTicket(*this, cameraIndex, cls, waiter->id, waited));
+}
+
+void TransferScheduler::interrupt() {
+    // Taking the lock orders the flag store before a waiter's next check
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cv.notify_all();
+}
+
+void TransferScheduler::stop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+    m_cv.notify_all();
+}
+
+nlohmann::json TransferScheduler::getStatus(const std::string& client) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    nlohmann::json cameras = nlohmann::json::array();
+    for (const auto& [index, lane] : m_lanes) {
+        nlohmann::json camera;
+        camera["camera"] = index;
+        camera["reads"] = describe(lane.pools[kReads], client);
+        camera["pulls"] = describe(lane.pools[kPulls], client);
+        cameras.push_back(camera);
+    }
+    return {
+        {"readsPerCamera", m_limits[kReads]},
+        {"pullsPerCamera", m_limits[kPulls]},
+        {"cameras", cameras}
+    };
+}
+
+bool TransferScheduler::parseClass(const std::string& name, TransferClass& cls) {
+    for (TransferClass c : {TransferClass::Thumbnail, TransferClass::Preview,
+                            TransferClass::Original, TransferClass::Bulk}) {
+        if (name == className(c)) {
+            cls = c;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* TransferScheduler::className(TransferClass cls) {
+    switch (cls) {
+        case TransferClass::Thumbnail: return "thumbnail";
+        case TransferClass::Preview: return "preview";
+        case TransferClass::Original: return "original";
+        case TransferClass::Bulk: return "bulk";
+    }
+    return "original";
+}
+
+TransferScheduler::PoolKind TransferScheduler::poolFor(TransferClass cls) {
+    return cls == TransferClass::Thumbnail ? kReads : kPulls;
+}
+
+double TransferScheduler::weightOf(TransferClass cls) {
+    // With every class backlogged on a camera, a bulk flow still gets one
+    // pull in every 13
+    switch (cls) {
+        case TransferClass::Thumbnail: return 1;
+        case TransferClass::Preview: return 8;
+        case TransferClass::Original: return 4;
+        case TransferClass::Bulk: return 1;
+    }
+    return 1;
+}
+
+TransferScheduler::Pool& TransferScheduler::poolLocked(int cameraIndex, TransferClass cls) {
+    auto it = m_lanes.find(cameraIndex);
+    if (it == m_lanes.end()) {
+        it = m_lanes.emplace(cameraIndex, Lane()).first;
+        for (int kind : {kReads, kPulls}) {
+            it->second.pools[kind].limit = m_limits[kind];
+        }
+    }
+    return it->second.pools[poolFor(cls)];
+}
+
+void TransferScheduler::dispatchLocked(Pool& pool) {
+    bool admitted = false;
+    while (static_cast<int>(pool.active.size()) < pool.limit && !pool.queued.empty()) {
+        // Lowest start tag first; ids break ties in arrival order
+        auto next = pool.queued.begin();
+        for (auto it = pool.queued.begin(); it != pool.queued.end(); ++it) {
+            if (it->second->start < next->second->start) {
+                next = it;
+            }
+        }
+
+        auto waiter = next->second;
+        pool.queued.erase(next);
+        pool.virtualTime = std::max(pool.virtualTime, waiter->start);
+        waiter->admitted = true;
+        waiter->admittedAt = std::chrono::steady_clock::now();
+        pool.active[waiter->id] = waiter;
+        admitted = true;
+    }
+
+    if (admitted) {
+        // Flows that finished behind virtual time start from it anyway
+        for (auto it = pool.lastFinish.begin(); it != pool.lastFinish.end();) {
+            it = it->second <= pool.virtualTime ? pool.lastFinish.erase(it) : std::next(it);
+        }
+        m_cv.notify_all();
+    }
+}
+
+void TransferScheduler::release(int cameraIndex, TransferClass cls, uint64_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Pool& pool = poolLocked(cameraIndex, cls);
+    pool.active.erase(id);
+    dispatchLocked(pool);
+    dropIfIdleLocked(cameraIndex);
+}
+
+void TransferScheduler::dropIfIdleLocked(int cameraIndex) {
+    auto it = m_lanes.find(cameraIndex);
+    if (it == m_lanes.end()) {
+        return;
+    }
+    // With nothing running or waiting there is no one to be fair to, so
+    // finish tags can go too; cameras come and go, and a lane is recreated
+    // on its next transfer
+    for (const Pool& pool : it->second.pools) {
+        if (!pool.active.empty() || !pool.queued.empty()) {
+            return;
+        }
+    }
+    m_lanes.erase(it);
+}
+
+nlohmann::json TransferScheduler::describe(const Pool& pool, const std::string& client) {
+    auto now = std::chrono::steady_clock::now();
+    auto ms = [](std::chrono::steady_clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+    };
+
+    nlohmann::json active = nlohmann::json::array();
+    for (const auto& [id, waiter] : pool.active) {
+        if (client.empty() || waiter->client == client) {
+            active.push_back({
+                {"id", id},
+                {"client", waiter->client},
+                {"class", className(waiter->cls)},
+                {"waitedMs", ms(waiter->admittedAt - waiter->queuedAt)},
+                {"runningMs", ms(now - waiter->admittedAt)}
+            });
+        }
+    }
+
+    nlohmann::json queued = nlohmann::json::array();
+    for (const auto& [id, waiter] : pool.queued) {
+        if (!client.empty() && waiter->client != client) {
+            continue;
+        }
+        int position = 1;
+        for (const auto& [otherId, other] : pool.queued) {
+            if (other->start < waiter->start || (other->start == waiter->start && otherId < id)) {
+                position++;
+            }
+        }
+        queued.push_back({
+            {"id", id},
+            {"client", waiter->client},
+            {"class", className(waiter->cls)},
+            {"position", position},
+            {"waitedMs", ms(now - waiter->queuedAt)}
+        });
+    }
+    std::sort(queued.begin(), queued.end(), [](const nlohmann::json& a, const nlohmann::json& b) {
+        return a["position"].get<int>() < b["position"].get<int>();
+    });
+
+    return {
+        {"limit", pool.limit},
+        {"active", active},
+        {"queued", queued},
+        {"queueLength", pool.queued.size()}
+    };
+}
+
+} // namespace crsdk_rest
@@ -1,9 +1,12 @@
 #include <iostream>
+#include <algorithm>
 #include <csignal>
 #include <atomic>
 #include "server/RestServer.h"
 #include "server/WebSocketHandler.h"
+#include "server/ArchiveStreamer.h"
 #include "camera/CameraManager.h"
+#include "util/SdkProfiler.h"
 
 std::atomic<bool> g_running{true};
 
@@ -19,6 +22,20 @@ int main(int argc, char* argv[]) {
     std::string host = "0.0.0.0";
     int port = 8080;
     int wsPort = 8081;
+    int discoveryInterval = 5;
+    std::string presetFile = "presets.json";
+    int readCacheTtl = 0;
+    std::string spoolDir = "spool";
+    int spoolSizeMb = static_cast<int>(crsdk_rest::ContentSpool::kDefaultBudgetBytes / (1024 * 1024));
+    std::string cacheDir = "cache";
+    int cacheSizeMb = 2048;
+    int thumbnailCacheMb = 64;
+    std::string offloadDir;
+    double offloadMaxMbps = 0;
+    int transferReads = crsdk_rest::TransferScheduler::kDefaultReadsPerCamera;
+    int transferPulls = crsdk_rest::TransferScheduler::kDefaultPullsPerCamera;
+    bool sdkProfiler = true;
+    int sdkSlowMs = 100;
 
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -28,12 +45,54 @@ int main(int argc, char* argv[]) {
             port = std::stoi(argv[++i]);
         } else if (arg == "--ws-port" && i + 1 < argc) {
             wsPort = std::stoi(argv[++i]);
+        } else if (arg == "--discovery-interval" && i + 1 < argc) {
+            discoveryInterval = std::stoi(argv[++i]);
+        } else if (arg == "--preset-file" && i + 1 < argc) {
+            presetFile = argv[++i];
+        } else if (arg == "--read-cache-ttl" && i + 1 < argc) {
+            readCacheTtl = std::stoi(argv[++i]);
+        } else if (arg == "--spool-dir" && i + 1 < argc) {
+            spoolDir = argv[++i];
+        } else if (arg == "--spool-size-mb" && i + 1 < argc) {
+            spoolSizeMb = std::stoi(argv[++i]);
+        } else if (arg == "--cache-dir" && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (arg == "--cache-size-mb" && i + 1 < argc) {
+            cacheSizeMb = std::stoi(argv[++i]);
+        } else if (arg == "--thumbnail-cache-mb" && i + 1 < argc) {
+            thumbnailCacheMb = std::stoi(argv[++i]);
+        } else if (arg == "--offload-dir" && i + 1 < argc) {
+            offloadDir = argv[++i];
+        } else if (arg == "--offload-max-mbps" && i + 1 < argc) {
+            offloadMaxMbps = std::stod(argv[++i]);
+        } else if (arg == "--transfer-reads" && i + 1 < argc) {
+            transferReads = std::stoi(argv[++i]);
+        } else if (arg == "--transfer-pulls" && i + 1 < argc) {
+            transferPulls = std::stoi(argv[++i]);
+        } else if (arg == "--no-sdk-profiler") {
+            sdkProfiler = false;
+        } else if (arg == "--sdk-slow-ms" && i + 1 < argc) {
+            sdkSlowMs = std::stoi(argv[++i]);
         } else if (arg == "--help" || arg == "-h") {
             std::cout << "Usage: " << argv[0] << " [options]\n"
                       << "Options:\n"
                       << "  --host <addr>     Bind address (default: 0.0.0.0)\n"
                       << "  --port <port>     HTTP port (default: 8080)\n"
                       << "  --ws-port <port>  WebSocket port (default: 8081)\n"
+                      << "  --discovery-interval <sec>  Camera rescan interval, 0 disables (default: 5)\n"
+                      << "  --preset-file <path>  Property preset store (default: presets.json)\n"
+                      << "  --read-cache-ttl <ms>  Reuse identical camera reads for this long (default: 0)\n"
+                      << "  --spool-dir <path>  Scratch directory for content downloads (default: spool)\n"
+                      << "  --spool-size-mb <mb>  Downloaded files kept for resumes (default: 4096)\n"
+                      << "  --cache-dir <path>  Persistent content and thumbnail cache (default: cache)\n"
+                      << "  --cache-size-mb <mb>  Content cache budget, 0 disables (default: 2048)\n"
+                      << "  --thumbnail-cache-mb <mb>  In-memory thumbnails per camera, 0 disables prefetch (default: 64)\n"
+                      << "  --offload-dir <path>  Copy new captures here as they are taken (default: off)\n"
+                      << "  --offload-max-mbps <mbit>  Bandwidth cap per camera for offloading, 0 is none (default: 0)\n"
+                      << "  --transfer-reads <n>  Thumbnail reads per camera at once (default: 2)\n"
+                      << "  --transfer-pulls <n>  File pulls per camera at once (default: 1)\n"
+                      << "  --no-sdk-profiler  Do not time SDK calls\n"
+                      << "  --sdk-slow-ms <ms>  Log SDK calls slower than this (default: 100)\n"
                       << "  --help, -h        Show this help\n";
             return 0;
         }
@@ -43,6 +102,10 @@ int main(int argc, char* argv[]) {
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
 
+    auto& profiler = crsdk_rest::SdkProfiler::getInstance();
+    profiler.setEnabled(sdkProfiler);
+    profiler.setSlowThresholdMs(sdkSlowMs);
+
     // Initialize SDK
     auto& manager = crsdk_rest::CameraManager::getInstance();
     if (!manager.initialize()) {
@@ -52,6 +115,14 @@ int main(int argc, char* argv[]) {
 
     std::cout << "SDK Version: 0x" << std::hex << manager.getSDKVersion() << std::dec << "\n";
 
+    manager.getPresets().load(presetFile);
+    manager.setReadCacheTtl(readCacheTtl);
+    manager.getSpool().open(spoolDir, static_cast<uint64_t>(std::max(spoolSizeMb, 0)) * 1024 * 1024);
+    manager.getContentCache().open(cacheDir, static_cast<uint64_t>(std::max(cacheSizeMb, 0)) * 1024 * 1024);
+    manager.setThumbnailCacheBudget(static_cast<size_t>(std::max(thumbnailCacheMb, 0)) * 1024 * 1024);
+    manager.getTransfers().setLimits(transferReads, transferPulls);
+    manager.getOffload().open(offloadDir, offloadMaxMbps);
+
     // Create and start server
     crsdk_rest::RestServer server(host, port, wsPort);
 
@@ -68,6 +139,8 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    manager.startDiscovery(discoveryInterval);
+
     std::cout << "\nServer running on http://" << host << ":" << port << "\n";
     std::cout << "WebSocket on ws://" << host << ":" << wsPort << "/events\n";
     std::cout << "Press Ctrl+C to stop.\n\n";
@@ -79,8 +152,15 @@ int main(int argc, char* argv[]) {
 
     std::cout << "\nShutting down...\n";
 
+    manager.getTransfers().stop();
     server.stop();
+    manager.getSequencer().stop();
+    manager.getOffload().stop();
+    manager.stopDiscovery();
     manager.disconnectAll();
+    crsdk_rest::ArchiveStreamer::drain();
+    manager.getContentCache().close();
+    manager.getSpool().close();
     manager.shutdown();
 
     std::cout << "Goodbye!\n";
@@ -0,0 +1,555 @@
+#include "server/ArchiveStreamer.h"
+#include "server/FileStreamer.h"
+#include "camera/CameraDeviceWrapper.h"
+#include "camera/CameraManager.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace crsdk_rest {
+
+namespace {
+
+constexpr uint64_t kZip32Limit = 0xFFFFFFFF;
+constexpr uint16_t kZipUtf8Names = 0x0800;
+constexpr uint32_t kZipUnixFileMode = 0100644u << 16;
+constexpr size_t kTarBlock = 512;
+constexpr size_t kTarNameField = 100;
+
+// One archive member. Zip offsets are where its local header starts.
+struct Member {
+    uint32_t handle = 0;
+    std::shared_ptr<const SpooledFile> file;  // Null if the pull failed
+    std::string name;
+    uint64_t size = 0;
+    std::time_t mtime = 0;
+    uint32_t crc = 0;
+    uint64_t offset = 0;
+};
+
+// Prefetches whose client went away. Dropping a std::async future blocks
+// until its pull ends, which can take minutes, so they wait here instead of
+// in an HTTP worker; finished ones are dropped as others arrive and drain()
+// joins the rest.
+std::mutex g_parkedMutex;
+std::vector<std::future<Member>> g_parked;
+
+void park(std::future<Member> pending) {
+    std::lock_guard<std::mutex> lock(g_parkedMutex);
+    g_parked.erase(std::remove_if(g_parked.begin(), g_parked.end(), [](const std::future<Member>& f) {
+        return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), g_parked.end());
+    g_parked.push_back(std::move(pending));
+}
+
+struct ArchiveState {
+    std::shared_ptr<CameraDeviceWrapper> camera;
+    std::string identity;
+    std::string client;  // For the transfer scheduler
+    std::vector<uint32_t> handles;
+    ArchiveFormat format = ArchiveFormat::Zip;
+
+    size_t next = 0;                   // Index of the pull in 'pending'
+    std::future<Member> pending;
+    std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+    Member current;                    // Being sent while fd is open
+    int fd = -1;
+    uint64_t sent = 0;                 // Of the current member's data
+    uint64_t offset = 0;               // Archive bytes written so far
+    std::vector<Member> members;       // Sent, for the zip central directory
+    std::vector<uint32_t> missing;
+    std::vector<char> buffer = std::vector<char>(FileStreamer::kChunkSize);
+
+    // A prefetch still running stops at its next check, and a bulk slot
+    // wait ends at once; the pull itself is parked rather than waited for
+    void cancel() {
+        cancelled->store(true);
+        if (pending.valid()) {
+            CameraManager::getInstance().getTransfers().interrupt();
+            park(std::move(pending));
+        }
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+        current = Member();
+    }
+
+    ~ArchiveState() {
+        cancel();
+    }
+};
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+    static const auto table = []() {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool crc32File(const std::string& path, uint32_t& crc) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::vector<uint8_t> buffer(FileStreamer::kChunkSize);
+    bool ok = true;
+    crc = 0;
+    while (true) {
+        ssize_t n = read(fd, buffer.data(), buffer.size());
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+            ok = false;
+            break;
+        }
+        crc = crc32Update(crc, buffer.data(), static_cast<size_t>(n));
+    }
+    close(fd);
+    return ok;
+}
+
+// The camera reports a UTC timestamp; its digits read as YYYYMMDDhhmmss
+std::time_t parseModified(const std::string& text) {
+    std::string digits;
+    for (char c : text) {
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            digits += c;
+        }
+    }
+    if (digits.size() < 14) {
+        return 0;
+    }
+
+    std::tm tm{};
+    tm.tm_year = std::stoi(digits.substr(0, 4)) - 1900;
+    tm.tm_mon = std::stoi(digits.substr(4, 2)) - 1;
+    tm.tm_mday = std::stoi(digits.substr(6, 2));
+    tm.tm_hour = std::stoi(digits.substr(8, 2));
+    tm.tm_min = std::stoi(digits.substr(10, 2));
+    tm.tm_sec = std::stoi(digits.substr(12, 2));
+    return timegm(&tm);
+}
+
+// Pull a content in the background: detail info for its timestamp, the file
+// itself and, for zip, its CRC, which the local header needs up front. The
+// future joins the prefetch; once cancelled is set it skips what it has not
+// started yet.
+std::future<Member> fetchMember(std::shared_ptr<CameraDeviceWrapper> camera, const std::string& identity,
+                                const std::string& client, uint32_t handle, ArchiveFormat format,
+                                std::shared_ptr<std::atomic<bool>> cancelled) {
+    return std::async(std::launch::async, [camera, identity, client, handle, format, cancelled]() {
+        Member member;
+        member.handle = handle;
+        if (cancelled->load()) {
+            return member;
+        }
+        try {
+            auto detail = camera->getContentsDetailInfo(handle);
+            auto& manager = CameraManager::getInstance();
+            auto file = manager.getSpool().acquire(*camera, identity, handle, false,
+                [&]() -> std::shared_ptr<TransferTicket> {
+                    if (cancelled->load()) {
+                        return nullptr;
+                    }
+                    auto ticket = manager.getTransfers().acquire(camera->getIndex(), client, TransferClass::Bulk,
+                                                                 cancelled.get());
+                    return cancelled->load() ? nullptr : ticket;
+                });
+            if (file && !cancelled->load() && (format != ArchiveFormat::Zip || crc32File(file->path, member.crc))) {
+                member.file = file;
+                member.name = file->name;
+                member.size = file->size;
+                if (detail.is_object()) {
+                    member.mtime = parseModified(detail.value("modified", ""));
+                }
+                struct stat st;
+                if (member.mtime == 0 && stat(file->path.c_str(), &st) == 0) {
+                    member.mtime = st.st_mtime;
+                }
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "[ArchiveStreamer] Content " << handle << ": " << e.what() << "\n";
+        }
+        return member;
+    });
+}
+
+void putLE(std::string& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out += static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+void dosDateTime(std::time_t t, uint16_t& date, uint16_t& time) {
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    if (tm.tm_year < 80) {
+        date = (1 << 5) | 1;  // 1980-01-01, the earliest DOS date
+        time = 0;
+        return;
+    }
+    date = static_cast<uint16_t>(((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday);
+    time = static_cast<uint16_t>((tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec / 2));
+}
+
+std::string zipLocalHeader(const Member& m) {
+    bool zip64 = m.size >= kZip32Limit;
+    uint16_t date, time;
+    dosDateTime(m.mtime, date, time);
+
+    std::string h;
+    putLE(h, 0x04034b50, 4);
+    putLE(h, zip64 ? 45 : 20, 2);  // Version needed
+    putLE(h, kZipUtf8Names, 2);
+    putLE(h, 0, 2);                // Stored
+    putLE(h, time, 2);
+    putLE(h, date, 2);
+    putLE(h, m.crc, 4);
+    putLE(h, zip64 ? kZip32Limit : m.size, 4);
+    putLE(h, zip64 ? kZip32Limit : m.size, 4);
+    putLE(h, m.name.size(), 2);
+    putLE(h, zip64 ? 20 : 0, 2);
+    h += m.name;
+    if (zip64) {
+        putLE(h, 0x0001, 2);
+        putLE(h, 16, 2);
+        putLE(h, m.size, 8);
+        putLE(h, m.size, 8);
+    }
+    return h;
+}
+
+std::string zipCentralHeader(const Member& m) {
+    bool bigSize = m.size >= kZip32Limit;
+    bool bigOffset = m.offset >= kZip32Limit;
+    uint16_t date, time;
+    dosDateTime(m.mtime, date, time);
+
+    std::string fields;
+    if (bigSize) {
+        putLE(fields, m.size, 8);
+        putLE(fields, m.size, 8);
+    }
+    if (bigOffset) {
+        putLE(fields, m.offset, 8);
+    }
+    std::string extra;
+    if (!fields.empty()) {
+        putLE(extra, 0x0001, 2);
+        putLE(extra, fields.size(), 2);
+        extra += fields;
+    }
+
+    std::string h;
+    putLE(h, 0x02014b50, 4);
+    putLE(h, (3 << 8) | 45, 2);    // Made by Unix, 4.5
+    putLE(h, extra.empty() ? 20 : 45, 2);
+    putLE(h, kZipUtf8Names, 2);
+    putLE(h, 0, 2);
+    putLE(h, time, 2);
+    putLE(h, date, 2);
+    putLE(h, m.crc, 4);
+    putLE(h, bigSize ? kZip32Limit : m.size, 4);
+    putLE(h, bigSize ? kZip32Limit : m.size, 4);
+    putLE(h, m.name.size(), 2);
+    putLE(h, extra.size(), 2);
+    putLE(h, 0, 2);                // Comment length
+    putLE(h, 0, 2);                // Disk number
+    putLE(h, 0, 2);                // Internal attributes
+    putLE(h, kZipUnixFileMode, 4);
+    putLE(h, bigOffset ? kZip32Limit : m.offset, 4);
+    h += m.name;
+    h += extra;
+    return h;
+}
+
+std::string zipEnd(uint64_t count, uint64_t cdOffset, uint64_t cdSize) {
+    std::string e;
+    if (count >= 0xFFFF || cdOffset >= kZip32Limit || cdSize >= kZip32Limit) {
+        putLE(e, 0x06064b50, 4);   // ZIP64 end of central directory
+        putLE(e, 44, 8);
+        putLE(e, (3 << 8) | 45, 2);
+        putLE(e, 45, 2);
+        putLE(e, 0, 4);
+        putLE(e, 0, 4);
+        putLE(e, count, 8);
+        putLE(e, count, 8);
+        putLE(e, cdSize, 8);
+        putLE(e, cdOffset, 8);
+
+        putLE(e, 0x07064b50, 4);   // Its locator
+        putLE(e, 0, 4);
+        putLE(e, cdOffset + cdSize, 8);
+        putLE(e, 1, 4);
+    }
+
+    putLE(e, 0x06054b50, 4);
+    putLE(e, 0, 2);
+    putLE(e, 0, 2);
+    putLE(e, std::min<uint64_t>(count, 0xFFFF), 2);
+    putLE(e, std::min<uint64_t>(count, 0xFFFF), 2);
+    putLE(e, std::min(cdSize, kZip32Limit), 4);
+    putLE(e, std::min(cdOffset, kZip32Limit), 4);
+    putLE(e, 0, 2);
+    return e;
+}
+
+void putOctal(char* field, size_t width, uint64_t value) {
+    std::snprintf(field, width, "%0*llo", static_cast<int>(width - 1), static_cast<unsigned long long>(value));
+}
+
+std::string tarPadding(uint64_t size) {
+    return std::string((kTarBlock - size % kTarBlock) % kTarBlock, '\0');
+}
+
+std::string tarBlock(const std::string& name, uint64_t size, std::time_t mtime, char type) {
+    std::string h(kTarBlock, '\0');
+    char* b = &h[0];
+
+    std::memcpy(b, name.data(), std::min<size_t>(name.size(), kTarNameField));
+    putOctal(b + 100, 8, 0644);
+    putOctal(b + 108, 8, 0);
+    putOctal(b + 116, 8, 0);
+    if (size < (1ULL << 33)) {
+        putOctal(b + 124, 12, size);
+    } else {
+        // Base-256: high bit set, big-endian in the remaining 11 bytes
+        b[124] = static_cast<char>(0x80);
+        for (int i = 11; i >= 1; i--) {
+            b[124 + i] = static_cast<char>(size & 0xFF);
+            size >>= 8;
+        }
+    }
+    putOctal(b + 136, 12, static_cast<uint64_t>(std::max<std::time_t>(mtime, 0)));
+    b[156] = type;
+    std::memcpy(b + 257, "ustar", 6);
+    std::memcpy(b + 263, "00", 2);
+
+    std::memset(b + 148, ' ', 8);
+    unsigned sum = 0;
+    for (unsigned char c : h) {
+        sum += c;
+    }
+    std::snprintf(b + 148, 8, "%06o", sum);
+    b[155] = ' ';
+    return h;
+}
+
+// Names that do not fit the header go in a PAX extended header before it.
+// Card file names have no directory part, so the ustar prefix field would
+// not help.
+std::string tarHeader(const Member& m) {
+    if (m.name.size() <= kTarNameField) {
+        return tarBlock(m.name, m.size, m.mtime, '0');
+    }
+
+    // "<length> path=<name>\n", the length counting its own digits
+    std::string body = " path=" + m.name + "\n";
+    size_t length = body.size();
+    while (std::to_string(length).size() + body.size() != length) {
+        length = std::to_string(length).size() + body.size();
+    }
+    std::string record = std::to_string(length) + body;
+
+    std::string shortName = m.name.substr(0, kTarNameField);
+    return tarBlock("PaxHeader/" + shortName, record.size(), m.mtime, 'x') + record + tarPadding(record.size()) +
+           tarBlock(shortName, m.size, m.mtime, '0');
+}
+
+bool writeOut(ArchiveState& state, httplib::DataSink& sink, const std::string& data) {
+    state.offset += data.size();
+    return data.empty() || sink.write(data.data(), data.size());
+}
+
+std::string memberHeader(ArchiveState& state, Member& m) {
+    if (state.format == ArchiveFormat::Tar) {
+        return tarHeader(m);
+    }
+    m.offset = state.offset;
+    Member entry = m;
+    entry.file.reset();
+    state.members.push_back(entry);
+    return zipLocalHeader(m);
+}
+
+bool finishMember(ArchiveState& state, httplib::DataSink& sink) {
+    close(state.fd);
+    state.fd = -1;
+    bool ok = state.format != ArchiveFormat::Tar || writeOut(state, sink, tarPadding(state.current.size));
+    state.current = Member();  // Lets the spool delete the file
+    return ok;
+}
+
+// Files that could not be pulled, listed in the archive itself since the
+// response status went out with the first entry
+bool writeMissingList(ArchiveState& state, httplib::DataSink& sink) {
+    std::string text;
+    for (uint32_t handle : state.missing) {
+        text += "Content " + std::to_string(handle) + " could not be transferred\n";
+    }
+
+    Member m;
+    m.name = "MISSING.txt";
+    m.size = text.size();
+    m.mtime = std::time(nullptr);
+    m.crc = crc32Update(0, reinterpret_cast<const uint8_t*>(text.data()), text.size());
+
+    std::string header = memberHeader(state, m);
+    std::string padding = state.format == ArchiveFormat::Tar ? tarPadding(text.size()) : "";
+    return writeOut(state, sink, header) && writeOut(state, sink, text) && writeOut(state, sink, padding);
+}
+
+bool writeTrailer(ArchiveState& state, httplib::DataSink& sink) {
+    if (!state.missing.empty() && !writeMissingList(state, sink)) {
+        return false;
+    }
+
+    if (state.format == ArchiveFormat::Tar) {
+        return writeOut(state, sink, std::string(2 * kTarBlock, '\0'));
+    }
+
+    uint64_t cdOffset = state.offset;
+    std::string directory;
+    for (const auto& m : state.members) {
+        directory += zipCentralHeader(m);
+    }
+    directory += zipEnd(state.members.size(), cdOffset, directory.size());
+    return writeOut(state, sink, directory);
+}
+
+bool startNextMember(ArchiveState& state, httplib::DataSink& sink) {
+    Member m = state.pending.get();
+    state.next++;
+    if (state.next < state.handles.size()) {
+        state.pending = fetchMember(state.camera, state.identity, state.client, state.handles[state.next],
+                                    state.format, state.cancelled);
+    }
+
+    int fd = m.file ? open(m.file->path.c_str(), O_RDONLY | O_CLOEXEC) : -1;
+    if (fd < 0) {
+        std::cerr << "[ArchiveStreamer] Leaving out content " << m.handle << "\n";
+        state.missing.push_back(m.handle);
+        return true;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    state.fd = fd;
+    state.sent = 0;
+    std::string header = memberHeader(state, m);
+    state.current = std::move(m);
+    if (!writeOut(state, sink, header)) {
+        return false;
+    }
+    return state.current.size > 0 || finishMember(state, sink);
+}
+
+bool sendChunk(ArchiveState& state, httplib::DataSink& sink) {
+    size_t toRead = static_cast<size_t>(
+        std::min<uint64_t>(state.buffer.size(), state.current.size - state.sent));
+    ssize_t n = pread(state.fd, state.buffer.data(), toRead, static_cast<off_t>(state.sent));
+    if (n <= 0) {
+        std::cerr << "[ArchiveStreamer] Could not read " << state.current.file->path << "\n";
+        return false;
+    }
+
+    state.sent += static_cast<uint64_t>(n);
+    state.offset += static_cast<uint64_t>(n);
+    if (!sink.write(state.buffer.data(), static_cast<size_t>(n))) {
+        return false;
+    }
+    return state.sent < state.current.size || finishMember(state, sink);
+}
+
+} // namespace
+
+bool ArchiveStreamer::parseFormat(const std::string& name, ArchiveFormat& format) {
+    if (name.empty() || name == "zip") {
+        format = ArchiveFormat::Zip;
+        return true;
+    }
+    if (name == "tar") {
+        format = ArchiveFormat::Tar;
+        return true;
+    }
+    return false;
+}
+
+std::string ArchiveStreamer::extensionFor(ArchiveFormat format) {
+    return format == ArchiveFormat::Zip ? "zip" : "tar";
+}
+
+void ArchiveStreamer::drain() {
+    std::vector<std::future<Member>> parked;
+    {
+        std::lock_guard<std::mutex> lock(g_parkedMutex);
+        parked.swap(g_parked);
+    }
+    for (auto& pending : parked) {
+        pending.wait();
+    }
+}
+
+void ArchiveStreamer::stream(httplib::Response& res, std::shared_ptr<CameraDeviceWrapper> camera,
+                             const std::string& cameraIdentity, const std::string& client,
+                             const std::vector<uint32_t>& handles, ArchiveFormat format) {
+    auto state = std::make_shared<ArchiveState>();
+    state->camera = camera;
+    state->identity = cameraIdentity;
+    state->client = client;
+    state->handles = handles;
+    state->format = format;
+
+    // The first pull starts before the response headers go out
+    if (!handles.empty()) {
+        state->pending = fetchMember(camera, cameraIdentity, client, handles[0], format, state->cancelled);
+    }
+
+    res.set_chunked_content_provider(
+        format == ArchiveFormat::Zip ? "application/zip" : "application/x-tar",
+        [state](size_t /*offset*/, httplib::DataSink& sink) {
+            if (state->fd >= 0) {
+                return sendChunk(*state, sink);
+            }
+            if (state->next < state->handles.size()) {
+                return startNextMember(*state, sink);
+            }
+
+            if (!writeTrailer(*state, sink)) {
+                return false;
+            }
+            std::cout << "[ArchiveStreamer] Sent " << state->handles.size() - state->missing.size() << " of "
+                      << state->handles.size() << " files, " << state->offset << " bytes\n";
+            sink.done();
+            return true;
+        },
+        [state](bool) { state->cancel(); });
+}
+
+} // namespace crsdk_rest
@@ -0,0 +1,107 @@
+#include "server/FileStreamer.h"
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace crsdk_rest {
+
+bool FileStreamer::serveFile(httplib::Response& res, const std::string& path,
+                             const std::string& contentType, std::function<void()> onDone) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    // Reads are sequential; let the kernel read ahead aggressively
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    auto buffer = std::make_shared<std::vector<char>>(kChunkSize);
+    res.set_content_provider(
+        static_cast<size_t>(st.st_size),
+        contentType.empty() ? contentTypeFor(path) : contentType,
+        [fd, buffer](size_t offset, size_t length, httplib::DataSink& sink) {
+            size_t toRead = std::min(length, buffer->size());
+            ssize_t n = pread(fd, buffer->data(), toRead, static_cast<off_t>(offset));
+            if (n <= 0) {
+                return false;
+            }
+            return sink.write(buffer->data(), static_cast<size_t>(n));
+        },
+        [fd, onDone](bool) {
+            close(fd);
+            if (onDone) {
+                onDone();
+            }
+        });
+    return true;
+}
+
+bool FileStreamer::serveMapped(httplib::Response& res, const std::string& path,
+                               const std::string& contentType) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    std::string type = contentType.empty() ? contentTypeFor(path) : contentType;
+    if (st.st_size == 0) {
+        close(fd);
+        res.set_content("", type);
+        return true;
+    }
+
+    // The mapping outlives the descriptor, and the file being unlinked
+    size_t size = static_cast<size_t>(st.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    res.set_content_provider(
+        size, type,
+        [data](size_t offset, size_t length, httplib::DataSink& sink) {
+            return sink.write(static_cast<const char*>(data) + offset, std::min(length, kChunkSize));
+        },
+        [data, size](bool) { munmap(data, size); });
+    return true;
+}
+
+std::string FileStreamer::contentTypeFor(const std::string& path) {
+    auto dot = path.find_last_of('.');
+    if (dot == std::string::npos) {
+        return "application/octet-stream";
+    }
+
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (ext == "jpg" || ext == "jpeg") return "image/jpeg";
+    if (ext == "hif" || ext == "heif" || ext == "heic") return "image/heif";
+    if (ext == "arw") return "image/x-sony-arw";
+    if (ext == "mp4") return "video/mp4";
+    if (ext == "mov") return "video/quicktime";
+    if (ext == "mxf") return "application/mxf";
+    return "application/octet-stream";
+}
+
+} // namespace crsdk_rest
@@ -2,6 +2,8 @@
 #include "server/WebSocketHandler.h"
 #include "server/MjpegStreamer.h"
 #include "api/ApiRouter.h"
+#include "api/JsonHelpers.h"
+#include "camera/CameraCommandQueue.h"
 #include <iostream>
 
 namespace crsdk_rest {
@@ -77,6 +79,23 @@ void RestServer::setupRoutes() {
         res.status = 204;
     });
 
+    // A camera that missed its deadline is a gateway timeout, not a crash
+    m_httpServer->set_exception_handler([](const httplib::Request&, httplib::Response& res,
+                                           std::exception_ptr error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const SdkTimeoutError& e) {
+            res.status = 504;
+            res.set_content(jsonError(504, e.what()).dump(), "application/json");
+        } catch (const std::exception& e) {
+            res.status = 500;
+            res.set_content(jsonError(500, e.what()).dump(), "application/json");
+        } catch (...) {
+            res.status = 500;
+            res.set_content(jsonError(500, "Internal server error").dump(), "application/json");
+        }
+    });
+
     // Setup API routes
     ApiRouter::setupRoutes(*m_httpServer, m_mjpegStreamer.get());
 }
@@ -0,0 +1,133 @@
+#include "server/ThumbnailBatchStreamer.h"
+#include "camera/CameraDeviceWrapper.h"
+#include "camera/CameraManager.h"
+#include "camera/TransferScheduler.h"
+#include "api/JsonHelpers.h"
+#include <atomic>
+#include <future>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace crsdk_rest {
+
+void ThumbnailBatchStreamer::stream(httplib::Response& res, std::shared_ptr<CameraDeviceWrapper> camera,
+                                    const std::string& client, const std::vector<uint32_t>& handles,
+                                    std::shared_ptr<TransferTicket> ticket) {
+    struct Batch {
+        std::shared_ptr<CameraDeviceWrapper> camera;
+        std::string client;
+        std::shared_ptr<TransferTicket> first;  // Taken before the response started
+        std::vector<uint32_t> handles;
+        std::vector<std::shared_future<std::vector<uint8_t>>> reads;
+        size_t next = 0;
+        std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+
+        // Each read from the camera waits for its own ticket, so thumbnails
+        // other clients ask for are taken in turn with the batch's
+        void readAhead(size_t ahead) {
+            while (reads.size() < handles.size() && reads.size() < next + ahead) {
+                uint32_t handle = handles[reads.size()];
+                if (auto cached = camera->getCachedThumbnail(handle)) {
+                    std::promise<std::vector<uint8_t>> ready;
+                    ready.set_value(std::move(*cached));
+                    reads.push_back(ready.get_future().share());
+                    continue;
+                }
+
+                auto ticket = first ? std::move(first)
+                                    : CameraManager::getInstance().getTransfers().acquire(
+                                          camera->getIndex(), client, TransferClass::Thumbnail);
+                if (!ticket) {
+                    std::promise<std::vector<uint8_t>> failed;
+                    failed.set_exception(std::make_exception_ptr(std::runtime_error("No transfer slot")));
+                    reads.push_back(failed.get_future().share());
+                    continue;
+                }
+                reads.push_back(camera->fetchThumbnailAsync(handle, cancelled, std::move(ticket)));
+            }
+        }
+    };
+
+    auto batch = std::make_shared<Batch>();
+    batch->camera = camera;
+    batch->client = client;
+    batch->first = std::move(ticket);
+    batch->handles = handles;
+    batch->readAhead(1);
+    batch->first.reset();  // Unused if the first thumbnails were in memory
+
+    std::string boundary = generateBoundary();
+
+    res.set_chunked_content_provider(
+        "multipart/mixed; boundary=" + boundary,
+        [batch, boundary](size_t /*offset*/, httplib::DataSink& sink) {
+            if (batch->next == batch->handles.size()) {
+                std::string closing = "--" + boundary + "--\r\n";
+                sink.write(closing.data(), closing.size());
+                sink.done();
+                return true;
+            }
+
+            batch->readAhead(1);
+            uint32_t handle = batch->handles[batch->next];
+            auto read = batch->reads[batch->next];
+            batch->next++;
+
+            std::vector<uint8_t> data;
+            std::string error = "Thumbnail not found";
+            try {
+                data = read.get();
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+
+            std::string body;
+            std::ostringstream header;
+            header << "--" << boundary << "\r\n";
+            if (!data.empty()) {
+                header << "Content-Type: image/jpeg\r\n";
+                header << "Content-Length: " << data.size() << "\r\n";
+            } else {
+                body = jsonError(404, error).dump();
+                header << "Content-Type: application/json\r\n";
+                header << "Content-Length: " << body.size() << "\r\n";
+            }
+            header << "X-Content-Handle: " << handle << "\r\n\r\n";
+
+            std::string headerStr = header.str();
+            if (!sink.write(headerStr.data(), headerStr.size())) {
+                return false;  // Client disconnected
+            }
+            bool written = data.empty()
+                ? sink.write(body.data(), body.size())
+                : sink.write(reinterpret_cast<const char*>(data.data()), data.size());
+            if (!written || !sink.write("\r\n", 2)) {
+                return false;
+            }
+            // Queued after this part went out, so a wait for a ticket never
+            // holds back a thumbnail already read
+            batch->readAhead(kReadAhead);
+            return true;
+        },
+        [batch](bool) {
+            // Reads the client will never see are skipped; their tickets go
+            // back once the queue drops them
+            batch->cancelled->store(true);
+        });
+}
+
+std::string ThumbnailBatchStreamer::generateBoundary() {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<> dis(0, 15);
+
+    const char* hex = "0123456789abcdef";
+    std::string boundary = "----ThumbnailBoundary";
+    for (int i = 0; i < 16; i++) {
+        boundary += hex[dis(gen)];
+    }
+    return boundary;
+}
+
+} // namespace crsdk_rest
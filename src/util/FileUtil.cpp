@@ -0,0 +1,44 @@
+#include "util/FileUtil.h"
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace crsdk_rest {
+
+bool copyFile(const std::string& from, const std::string& to) {
+    int in = open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return false;
+    }
+    int out = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        close(in);
+        return false;
+    }
+
+    std::vector<char> buffer(256 * 1024);
+    bool ok = true;
+    while (true) {
+        ssize_t n = read(in, buffer.data(), buffer.size());
+        if (n == 0) {
+            break;
+        }
+        if (n < 0 || write(out, buffer.data(), static_cast<size_t>(n)) != n) {
+            ok = false;
+            break;
+        }
+    }
+
+    close(in);
+    ok = close(out) == 0 && ok;
+    if (!ok) {
+        unlink(to.c_str());
+    }
+    return ok;
+}
+
+bool linkOrCopyFile(const std::string& from, const std::string& to) {
+    return link(from.c_str(), to.c_str()) == 0 || copyFile(from, to);
+}
+
+} // namespace crsdk_rest
@@ -0,0 +1,182 @@
+#include "util/SdkProfiler.h"
+#include <algorithm>
+#include <sstream>
+
+namespace crsdk_rest {
+
+namespace {
+
+int bucketFor(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int bucket = 0;
+    while (us > 0 && bucket < 31) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+std::string hexCode(uint32_t code) {
+    std::ostringstream out;
+    out << "0x" << std::hex << code;
+    return out.str();
+}
+
+} // namespace
+
+SdkProfiler& SdkProfiler::getInstance() {
+    static SdkProfiler instance;
+    return instance;
+}
+
+void SdkProfiler::record(SdkFunction fn, int cameraIndex, uint64_t ns, uint32_t error,
+                         uint64_t arg0, uint64_t arg1) {
+    size_t fnIndex = static_cast<size_t>(fn);
+    int slot = cameraSlot(cameraIndex);
+    auto& stats = m_stats[fnIndex][slot];
+
+    stats.calls.fetch_add(1, std::memory_order_relaxed);
+    stats.totalNs.fetch_add(ns, std::memory_order_relaxed);
+    stats.buckets[bucketFor(ns)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = stats.maxNs.load(std::memory_order_relaxed);
+    while (ns > max && !stats.maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+
+    bool slow = ns >= m_slowThresholdNs.load(std::memory_order_relaxed);
+    if (error == 0 && !slow) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (error != 0) {
+        stats.errors.fetch_add(1, std::memory_order_relaxed);
+        m_errorCodes[{fnIndex, slot}][error]++;
+    }
+    if (slow) {
+        m_slowCalls[m_slowCallCount % kSlowCalls] =
+            SlowCall{fn, cameraIndex, ns, error, arg0, arg1, std::chrono::system_clock::now()};
+        m_slowCallCount++;
+    }
+}
+
+nlohmann::json SdkProfiler::toJson() const {
+    nlohmann::json functions = nlohmann::json::array();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t fn = 0; fn < kFunctions; fn++) {
+        for (int slot = 0; slot <= kMaxCameras; slot++) {
+            const auto& stats = m_stats[fn][slot];
+            uint64_t calls = stats.calls.load(std::memory_order_relaxed);
+            if (calls == 0) {
+                continue;
+            }
+
+            std::array<uint64_t, kBuckets> buckets;
+            uint64_t bucketTotal = 0;
+            for (int b = 0; b < kBuckets; b++) {
+                buckets[b] = stats.buckets[b].load(std::memory_order_relaxed);
+                bucketTotal += buckets[b];
+            }
+
+            // Upper bound of the bucket holding the given fraction of calls
+            auto percentileUs = [&](double fraction) -> uint64_t {
+                uint64_t target = static_cast<uint64_t>(fraction * bucketTotal);
+                uint64_t seen = 0;
+                for (int b = 0; b < kBuckets; b++) {
+                    seen += buckets[b];
+                    if (seen > target) {
+                        return uint64_t(1) << b;
+                    }
+                }
+                return uint64_t(1) << (kBuckets - 1);
+            };
+
+            nlohmann::json entry;
+            entry["function"] = functionName(static_cast<SdkFunction>(fn));
+            entry["camera"] = slot == kMaxCameras ? -1 : slot;
+            entry["calls"] = calls;
+            entry["errors"] = stats.errors.load(std::memory_order_relaxed);
+            entry["meanUs"] = stats.totalNs.load(std::memory_order_relaxed) / 1000.0 / calls;
+            entry["maxUs"] = stats.maxNs.load(std::memory_order_relaxed) / 1000.0;
+            entry["p50Us"] = percentileUs(0.50);
+            entry["p90Us"] = percentileUs(0.90);
+            entry["p99Us"] = percentileUs(0.99);
+
+            auto errors = m_errorCodes.find({fn, slot});
+            if (errors != m_errorCodes.end()) {
+                nlohmann::json codes = nlohmann::json::object();
+                for (const auto& pair : errors->second) {
+                    codes[hexCode(pair.first)] = pair.second;
+                }
+                entry["errorCodes"] = codes;
+            }
+            functions.push_back(entry);
+        }
+    }
+
+    // Newest first
+    nlohmann::json slowCalls = nlohmann::json::array();
+    size_t count = std::min(m_slowCallCount, kSlowCalls);
+    for (size_t i = 0; i < count; i++) {
+        const auto& call = m_slowCalls[(m_slowCallCount - 1 - i) % kSlowCalls];
+        slowCalls.push_back({
+            {"function", functionName(call.fn)},
+            {"camera", call.cameraIndex},
+            {"us", call.ns / 1000.0},
+            {"error", hexCode(call.error)},
+            {"args", {call.arg0, call.arg1}},
+            {"at", std::chrono::duration_cast<std::chrono::milliseconds>(
+                call.at.time_since_epoch()).count()}
+        });
+    }
+
+    return {
+        {"enabled", m_enabled.load()},
+        {"slowThresholdMs", m_slowThresholdNs.load() / 1000000},
+        {"functions", functions},
+        {"slowCalls", slowCalls},
+        {"slowCallsTotal", m_slowCallCount}
+    };
+}
+
+void SdkProfiler::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& row : m_stats) {
+        for (auto& stats : row) {
+            stats.calls.store(0);
+            stats.errors.store(0);
+            stats.totalNs.store(0);
+            stats.maxNs.store(0);
+            for (auto& bucket : stats.buckets) {
+                bucket.store(0);
+            }
+        }
+    }
+    m_errorCodes.clear();
+    m_slowCallCount = 0;
+}
+
+const char* SdkProfiler::functionName(SdkFunction fn) {
+    switch (fn) {
+        case SdkFunction::EnumCameraObjects: return "EnumCameraObjects";
+        case SdkFunction::Connect: return "Connect";
+        case SdkFunction::Disconnect: return "Disconnect";
+        case SdkFunction::ReleaseDevice: return "ReleaseDevice";
+        case SdkFunction::GetDeviceProperties: return "GetDeviceProperties";
+        case SdkFunction::GetSelectDeviceProperties: return "GetSelectDeviceProperties";
+        case SdkFunction::SetDeviceProperty: return "SetDeviceProperty";
+        case SdkFunction::SendCommand: return "SendCommand";
+        case SdkFunction::GetLiveViewImageInfo: return "GetLiveViewImageInfo";
+        case SdkFunction::GetLiveViewImage: return "GetLiveViewImage";
+        case SdkFunction::GetDateFolderList: return "GetDateFolderList";
+        case SdkFunction::GetContentsHandleList: return "GetContentsHandleList";
+        case SdkFunction::GetContentsDetailInfo: return "GetContentsDetailInfo";
+        case SdkFunction::PullContentsFile: return "PullContentsFile";
+        case SdkFunction::GetContentsThumbnailImage: return "GetContentsThumbnailImage";
+        case SdkFunction::Count: break;
+    }
+    return "unknown";
+}
+
+} // namespace crsdk_rest
@@ -0,0 +1,177 @@
+#include "util/Xxh64.h"
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace crsdk_rest {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+constexpr size_t kFileChunk = 1024 * 1024;
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Little-endian loads; memcpy keeps them legal at any alignment
+inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+inline uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+inline uint64_t mixRound(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+    acc ^= mixRound(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+} // namespace
+
+Xxh64::Xxh64(uint64_t seed) : m_seed(seed) {
+    m_acc[0] = seed + kPrime1 + kPrime2;
+    m_acc[1] = seed + kPrime2;
+    m_acc[2] = seed;
+    m_acc[3] = seed - kPrime1;
+}
+
+void Xxh64::update(const void* data, size_t size) {
+    auto p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    m_total += size;
+
+    if (m_buffered + size < sizeof(m_buffer)) {
+        std::memcpy(m_buffer + m_buffered, p, size);
+        m_buffered += size;
+        return;
+    }
+
+    if (m_buffered > 0) {
+        size_t fill = sizeof(m_buffer) - m_buffered;
+        std::memcpy(m_buffer + m_buffered, p, fill);
+        p += fill;
+        for (int lane = 0; lane < 4; lane++) {
+            m_acc[lane] = mixRound(m_acc[lane], read64(m_buffer + lane * 8));
+        }
+        m_buffered = 0;
+    }
+
+    // The four lanes are independent, so this loop keeps the multipliers busy
+    uint64_t v1 = m_acc[0], v2 = m_acc[1], v3 = m_acc[2], v4 = m_acc[3];
+    while (end - p >= 32) {
+        v1 = mixRound(v1, read64(p));
+        v2 = mixRound(v2, read64(p + 8));
+        v3 = mixRound(v3, read64(p + 16));
+        v4 = mixRound(v4, read64(p + 24));
+        p += 32;
+    }
+    m_acc[0] = v1;
+    m_acc[1] = v2;
+    m_acc[2] = v3;
+    m_acc[3] = v4;
+
+    m_buffered = static_cast<size_t>(end - p);
+    std::memcpy(m_buffer, p, m_buffered);
+}
+
+uint64_t Xxh64::digest() const {
+    uint64_t h;
+    if (m_total >= 32) {
+        h = rotl(m_acc[0], 1) + rotl(m_acc[1], 7) + rotl(m_acc[2], 12) + rotl(m_acc[3], 18);
+        for (uint64_t acc : m_acc) {
+            h = mergeRound(h, acc);
+        }
+    } else {
+        h = m_seed + kPrime5;
+    }
+    h += m_total;
+
+    const unsigned char* p = m_buffer;
+    const unsigned char* end = m_buffer + m_buffered;
+    while (end - p >= 8) {
+        h ^= mixRound(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+    if (end - p >= 4) {
+        h ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+bool Xxh64::hashFile(const std::string& path, uint64_t& digest) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    Xxh64 hash;
+    std::vector<unsigned char> buffer(kFileChunk);
+    bool ok = true;
+    while (true) {
+        ssize_t n = read(fd, buffer.data(), buffer.size());
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+            ok = false;
+            break;
+        }
+        hash.update(buffer.data(), static_cast<size_t>(n));
+    }
+    close(fd);
+
+    if (ok) {
+        digest = hash.digest();
+    }
+    return ok;
+}
+
+std::string Xxh64::format(uint64_t digest) {
+    static const char* hex = "0123456789abcdef";
+    std::string out = "xxh64:";
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        out += hex[(digest >> shift) & 0xF];
+    }
+    return out;
+}
+
+} // namespace crsdk_rest